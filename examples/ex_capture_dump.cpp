@@ -0,0 +1,74 @@
+#include <Mahi/Fes.hpp>
+#include <Mahi/Util.hpp>
+#include <cstdio>
+
+using namespace mahi::util;
+using namespace mahi::fes;
+
+// runs a short session against an emulated UECU with a capture running, so there is something to dump
+bool record_session(const std::string& filename) {
+    std::vector<Channel> channels;
+    Channel bicep("Bicep", CH_1, AN_CA_1, 100, 250);
+    channels.push_back(bicep);
+
+    auto link = LoopbackTransport::make_pair("emulated");
+    std::unique_ptr<Transport> board = std::move(link.second);
+    board->open();
+    std::vector<std::unique_ptr<Transport>> transports;
+    transports.push_back(std::move(link.first));
+    // the capture is started before the stimulator enables, so the setup messages are in it too
+    Stimulator stim("Emulated UECU", channels, std::move(transports), false, filename);
+
+    UecuEmulator emulator(*board);
+    emulator.start();
+
+    if (!stim.is_enabled() || !stim.create_scheduler(0xAA, 40) || !stim.add_events(channels)) return false;
+    stim.begin();
+    for (int i = 0; i < 10; i++) {
+        stim.set_amp(bicep, 10 + i);
+        stim.write_pw(bicep, 100);
+        stim.update();
+        sleep(milliseconds(25));
+    }
+    stim.disable();
+    stim.stop_capture();
+    emulator.stop();
+
+    CaptureStats stats = stim.get_capture_stats();
+    print_var(stats.records);
+    print_var(stats.dropped);
+    return true;
+}
+
+int main(int argc, char* argv[]) {
+    // Prints every record of a capture file, eg. capture_dump session.fescap. With no file, a short
+    // session against an emulated UECU is captured to fes_capture.fescap first and that is printed
+    std::string filename = "fes_capture.fescap";
+    if (argc > 1) {
+        filename = argv[1];
+    } else if (!record_session(filename)) {
+        return 1;
+    }
+
+    CaptureReader reader;
+    if (!reader.open(filename)) return 1;
+
+    CaptureRecord record;
+    std::uint64_t first_ns = 0;
+    size_t        records  = 0;
+    size_t        bytes[2] = {0, 0};
+    while (reader.next(record)) {
+        if (records == 0) first_ns = record.time_ns;
+        std::printf("%12.6f  port %d  %s  ", (record.time_ns - first_ns) * 1e-9, (int)record.port,
+                    record.received ? "rx" : "tx");
+        for (size_t i = 0; i < record.size; i++) std::printf("%02X ", (int)record.data[i]);
+        std::printf("\n");
+        records++;
+        bytes[record.received ? 1 : 0] += record.size;
+    }
+
+    print_var(records);
+    print_var(bytes[0]);
+    print_var(bytes[1]);
+    return 0;
+}
@@ -0,0 +1,112 @@
+#include <Mahi/Fes.hpp>
+#include <Mahi/Util.hpp>
+#include <random>
+
+using namespace mahi::util;
+using namespace mahi::fes;
+
+// the bit at a time crc that calc_crc used before it went to a lookup table, to compare against
+unsigned int calc_crc_bitwise(const unsigned char* data, size_t size) {
+    unsigned int crc = CRC_SEED;
+    for (size_t pos = 0; pos < size; pos++) {
+        crc = crc ^ data[pos];
+        for (int i = 8; i > 0; i--) {
+            if (crc & 0x0001) crc = (crc >> 1) ^ CRC_POLY;
+            else crc >>= 1;
+        }
+    }
+    return crc;
+}
+
+// builds a reply the way the UECU sends it, with a valid crc
+std::vector<unsigned char> make_reply(unsigned char type, const std::vector<unsigned char>& data) {
+    std::vector<unsigned char> reply = {0x02, 0x34, 0xAA, (unsigned char)(data.size() + 4), SRC_ADR, DEST_ADR, type, (unsigned char)data.size()};
+    reply.insert(reply.end(), data.begin(), data.end());
+    unsigned int crc = calc_crc_bitwise(&reply[0], reply.size());
+    reply.push_back((unsigned char)(crc & 0xFF));
+    reply.push_back((unsigned char)(crc >> 8));
+    return reply;
+}
+
+int main(int argc, char* argv[]) {
+    // Times checking the crcs of many replies three ways: the old bit at a time crc, the lookup
+    // table crc one reply at a time, and check_crcs on all of them at once. Pass a capture file
+    // (see Stimulator::start_capture) to use the replies it holds instead of generated ones, eg.
+    // crc_bench session.fescap
+    std::vector<std::vector<unsigned char>> replies;
+    if (argc > 1) {
+        CaptureReader reader;
+        if (!reader.open(argv[1])) return 1;
+        // the crc check is what is being timed, so let through everything that looks like a reply
+        ReplyParser   parser([&](const Reply& reply) { replies.push_back(reply.get_message()); });
+        CaptureRecord record;
+        while (reader.next(record)) {
+            if (record.received) parser.feed(record.data, record.size);
+        }
+        if (replies.empty()) {
+            LOG(Error) << "No replies in " << argv[1];
+            return 1;
+        }
+    } else {
+        // mostly event command replies, with the odd creation reply, error report, and one in a
+        // hundred corrupted
+        std::mt19937 rng(42);
+        for (size_t i = 0; i < 200000; i++) {
+            switch (rng() % 8) {
+                case 0:  replies.push_back(make_reply(CREATE_SCHEDULE_REPLY_MSG, {(unsigned char)(rng() % 4 + 1)})); break;
+                case 1:  replies.push_back(make_reply(CREATE_EVENT_REPLY_MSG, {(unsigned char)(rng() % 8 + 1), 0x01, STIM_EVENT, 0x00})); break;
+                case 2:  replies.push_back(make_reply(ERROR_REPORT_MSG, {(unsigned char)(rng() % 16), CHANGE_EVENT_PARAMS_MSG})); break;
+                default: replies.push_back(make_reply(EVENT_COMMAND_REPLY_MSG, {(unsigned char)(rng() % 8 + 1), STIM_EVENT, 0x00})); break;
+            }
+            if (rng() % 100 == 0) replies.back()[rng() % replies.back().size()] ^= 0x10;
+        }
+    }
+
+    std::vector<const unsigned char*> pointers(replies.size());
+    std::vector<size_t>               sizes(replies.size());
+    size_t                            bytes = 0;
+    for (size_t i = 0; i < replies.size(); i++) {
+        pointers[i] = &replies[i][0];
+        sizes[i]    = replies[i].size();
+        bytes += sizes[i];
+    }
+
+    const int passes = 20;
+    size_t    matched[3] = {0, 0, 0};
+    double    seconds[3] = {0, 0, 0};
+    bool*     valid      = new bool[replies.size()];
+
+    Clock bench_clock;
+    for (int pass = 0; pass < passes; pass++) {
+        matched[0] = 0;
+        for (size_t i = 0; i < replies.size(); i++) {
+            unsigned int crc = calc_crc_bitwise(pointers[i], sizes[i] - 2);
+            if (pointers[i][sizes[i] - 2] == (crc & 0xFF) && pointers[i][sizes[i] - 1] == (crc >> 8)) matched[0]++;
+        }
+    }
+    seconds[0] = bench_clock.restart().as_seconds();
+
+    for (int pass = 0; pass < passes; pass++) {
+        matched[1] = 0;
+        for (size_t i = 0; i < replies.size(); i++) {
+            unsigned int crc = calc_crc(pointers[i], sizes[i] - 2);
+            if (pointers[i][sizes[i] - 2] == (crc & 0xFF) && pointers[i][sizes[i] - 1] == (crc >> 8)) matched[1]++;
+        }
+    }
+    seconds[1] = bench_clock.restart().as_seconds();
+
+    for (int pass = 0; pass < passes; pass++) {
+        matched[2] = check_crcs(&pointers[0], &sizes[0], replies.size(), valid);
+    }
+    seconds[2] = bench_clock.restart().as_seconds();
+    delete[] valid;
+
+    const char* names[3] = {"bitwise", "table", "batch"};
+    for (int i = 0; i < 3; i++) {
+        std::cout << names[i] << ": " << matched[i] << "/" << replies.size() << " matched, "
+                  << seconds[i] * 1e9 / (passes * replies.size()) << " ns/reply, "
+                  << bytes * passes / seconds[i] / 1e6 << " MB/s" << std::endl;
+    }
+    // all three have to agree for the timings to mean anything
+    return matched[0] == matched[1] && matched[1] == matched[2] ? 0 : 1;
+}
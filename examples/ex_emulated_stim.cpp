@@ -0,0 +1,85 @@
+#include <Mahi/Fes.hpp>
+#include <Mahi/Util.hpp>
+
+using namespace mahi::util;
+using namespace mahi::fes;
+
+int main(int argc, char* argv[]) {
+    // Runs the stimulator against an emulated UECU, replies and all, so no board is needed. By
+    // default the emulator sits on the other end of an in-process loopback link. Pass "pty"
+    // (Linux only) to put it behind a pseudo terminal instead, so that the stimulator goes through
+    // the real serial port code, eg. emulated_stim pty
+    bool use_pty = argc > 1 && std::string(argv[1]) == "pty";
+
+    std::vector<Channel> channels;
+    Channel bicep("Bicep", CH_1, AN_CA_1, 100, 250);
+    channels.push_back(bicep);
+    Channel tricep("Tricep", CH_2, AN_CA_2, 100, 250);
+    channels.push_back(tricep);
+
+    std::unique_ptr<Transport>  board;
+    std::unique_ptr<Stimulator> stim;
+    if (use_pty) {
+#ifdef _WIN32
+        LOG(Error) << "pty links are only available on Linux";
+        return 1;
+#else
+        PtyTransport* pty = new PtyTransport();
+        board.reset(pty);
+        if (!board->open()) return 1;
+        stim.reset(new Stimulator("Emulated UECU", channels, pty->get_slave_name(), "NONE", false));
+#endif
+    } else {
+        auto link = LoopbackTransport::make_pair("emulated");
+        board     = std::move(link.second);
+        board->open();
+        std::vector<std::unique_ptr<Transport>> transports;
+        transports.push_back(std::move(link.first));
+        stim.reset(new Stimulator("Emulated UECU", channels, std::move(transports), false));
+    }
+
+    UecuEmulator emulator(*board);
+    emulator.start();
+
+    // the board answers these, so this exercises the same handshakes as real hardware
+    if (!stim->create_scheduler(0xAA, 40) || !stim->add_events(channels)) return 1;
+    stim->begin();
+
+    for (auto& schedule : emulator.get_schedules()) {
+        LOG(Info) << "Schedule " << (int)schedule.id << ": " << schedule.duration << " ms, running " << schedule.running;
+    }
+
+    Timer  timer(milliseconds(25), Timer::WaitMode::Hybrid);
+    Clock  update_clock;
+    Time   longest_update = Time::Zero;
+    double t              = 0.0;
+    while (t < 2.0) {
+        stim->set_amp(bicep, 30 + int(20 * sin(t)));
+        stim->write_pw(bicep, 100);
+        stim->set_amp(tricep, 30 + int(20 * cos(t)));
+        stim->write_pw(tricep, 100);
+
+        update_clock.restart();
+        if (!stim->update()) break;
+        if (update_clock.get_elapsed_time() > longest_update) longest_update = update_clock.get_elapsed_time();
+
+        t = timer.wait().as_seconds();
+    }
+
+    // what the board ended up with should match what was last set
+    for (auto& event : emulator.get_events()) {
+        LOG(Info) << "Event " << (int)event.id << " on channel " << (int)event.channel << ": pw " << (int)event.pulse_width
+                  << ", amplitude " << (int)event.amplitude;
+    }
+
+    stim->disable();
+    emulator.stop();
+
+    UecuEmulatorStats stats = emulator.get_stats();
+    print_var(longest_update.as_microseconds());
+    print_var(stats.messages);
+    print_var(stats.replies);
+    print_var(stats.checksum_errors);
+    print_var(stats.errors_reported);
+    return 0;
+}
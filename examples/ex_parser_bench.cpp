@@ -0,0 +1,103 @@
+#include <Mahi/Fes.hpp>
+#include <Mahi/Util.hpp>
+#include <fstream>
+#include <iterator>
+#include <random>
+
+using namespace mahi::util;
+using namespace mahi::fes;
+
+// builds a reply the way the UECU sends it, with a valid crc
+void append_reply(std::vector<unsigned char>& stream, unsigned char type, const std::vector<unsigned char>& data) {
+    size_t start = stream.size();
+    unsigned char header[] = {0x02, 0x34, 0xAA, (unsigned char)(data.size() + 4), SRC_ADR, DEST_ADR, type, (unsigned char)data.size()};
+    stream.insert(stream.end(), header, header + 8);
+    stream.insert(stream.end(), data.begin(), data.end());
+    unsigned int crc = calc_crc(&stream[start], stream.size() - start);
+    stream.push_back((unsigned char)(crc & 0xFF));
+    stream.push_back((unsigned char)(crc >> 8));
+}
+
+int main(int argc, char* argv[]) {
+    // Feeds a long stream of replies through the ReplyParser in randomly sized pieces (like reads
+    // from a serial port would be) and reports how fast it goes and how many replies survive the
+    // corruption. Pass a file of raw bytes received from a board to use captured traffic instead
+    // of the generated replies, eg. parser_bench capture.bin
+    std::mt19937 rng(42);
+
+    std::vector<unsigned char> stream;
+    size_t                     intact = 0;  // replies that were not touched by the corruption
+    if (argc > 1) {
+        std::ifstream file(argv[1], std::ios::binary);
+        if (!file) {
+            LOG(Error) << "Could not open " << argv[1];
+            return 1;
+        }
+        stream.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    } else {
+        // the replies the UECU sends while running: event command replies mostly, with the odd
+        // schedule/event creation reply and error report
+        const size_t target_size = 8 * 1024 * 1024;
+        while (stream.size() < target_size) {
+            switch (rng() % 8) {
+                case 0:  append_reply(stream, CREATE_SCHEDULE_REPLY_MSG, {(unsigned char)(rng() % 4 + 1)}); break;
+                case 1:  append_reply(stream, CREATE_EVENT_REPLY_MSG, {(unsigned char)(rng() % 8 + 1), 0x01, STIM_EVENT, 0x00}); break;
+                case 2:  append_reply(stream, ERROR_REPORT_MSG, {(unsigned char)(rng() % 16), CHANGE_EVENT_PARAMS_MSG}); break;
+                default: append_reply(stream, EVENT_COMMAND_REPLY_MSG, {(unsigned char)(rng() % 8 + 1), STIM_EVENT, 0x00}); break;
+            }
+            intact++;
+        }
+    }
+
+    // inject corruption about once every 2000 bytes: flipped bits, lost bytes, and noise bytes
+    size_t corruptions = 0;
+    std::vector<unsigned char> corrupted;
+    corrupted.reserve(stream.size() + stream.size() / 1000);
+    for (size_t i = 0; i < stream.size(); i++) {
+        if (rng() % 2000 == 0) {
+            corruptions++;
+            switch (rng() % 3) {
+                case 0: corrupted.push_back(stream[i] ^ (unsigned char)(1 << (rng() % 8))); break;
+                case 1: break;
+                case 2: corrupted.push_back((unsigned char)rng()); corrupted.push_back(stream[i]); break;
+            }
+        } else {
+            corrupted.push_back(stream[i]);
+        }
+    }
+
+    // only the counters are of interest here, so the replies themselves are ignored
+    ReplyParser parser([](const Reply&) {});
+
+    // split the stream up front so that only the parser is timed
+    std::vector<size_t> chunks;
+    for (size_t fed = 0; fed < corrupted.size();) {
+        size_t chunk = std::min<size_t>(rng() % 64 + 1, corrupted.size() - fed);
+        chunks.push_back(chunk);
+        fed += chunk;
+    }
+
+    Clock  bench_clock;
+    size_t offset = 0;
+    for (size_t i = 0; i < chunks.size(); i++) {
+        parser.feed(&corrupted[offset], chunks[i]);
+        offset += chunks[i];
+    }
+    double seconds = bench_clock.get_elapsed_time().as_seconds();
+
+    ReplyParserStats stats = parser.get_stats();
+    print_var(corrupted.size());
+    print_var(corruptions);
+    print_var(seconds);
+    print_var(corrupted.size() / seconds / 1e6);  // MB/s
+    print_var(stats.replies);
+    print_var(stats.crc_errors);
+    print_var(stats.discarded);
+    if (argc <= 1) {
+        // every corruption should cost at most the reply it lands in
+        size_t expected_at_least = intact - corruptions;
+        print_var(intact);
+        print_var(expected_at_least);
+    }
+    return 0;
+}
@@ -0,0 +1,104 @@
+#include <Mahi/Fes.hpp>
+#include <Mahi/Util.hpp>
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+
+using namespace mahi::util;
+using namespace mahi::fes;
+
+int main(int argc, char* argv[]) {
+    // End to end latency of the host side, from set_amp to the event update being parsed on the
+    // board side of a pty. The stimulator opens the slave end as its serial port, and an emulated
+    // UECU on the master end answers the schedule/event creation like a board would. A pty has no
+    // baud rate, so this measures the software path (batching, threads, transport) rather than the
+    // wire. eg. pty_bench 100 4 5 io -> 100 Hz updates of 4 channels for 5 s, with I/O threads
+#ifdef _WIN32
+    LOG(Error) << "The pty benchmark is only available on Linux";
+    return 1;
+#else
+    double rate        = argc > 1 ? atof(argv[1]) : 100.0;
+    size_t channels    = argc > 2 ? std::min<size_t>(std::max(atoi(argv[2]), 1), 4) : 4;
+    double duration    = argc > 3 ? atof(argv[3]) : 5.0;
+    bool   io_threaded = argc > 4 && std::string(argv[4]) == "io";
+
+    std::vector<Channel> all_channels = {Channel("Ch 1", CH_1, AN_CA_1, 100, 250), Channel("Ch 2", CH_2, AN_CA_2, 100, 250),
+                                         Channel("Ch 3", CH_3, AN_CA_3, 100, 250), Channel("Ch 4", CH_4, AN_CA_4, 100, 250)};
+    std::vector<Channel> stim_channels(all_channels.begin(), all_channels.begin() + channels);
+
+    PtyTransport board;
+    if (!board.open()) return 1;
+
+    // when each amplitude was set, by event id and amplitude, so that the board side can tell how
+    // long the update it just parsed took to get there
+    static std::atomic<std::int64_t> set_times[256][256];
+    Clock                            bench_clock;
+    std::mutex                       latency_mtx;
+    std::vector<std::int64_t>        latencies;
+
+    UecuEmulator emulator(board);
+    emulator.set_on_message([&](const unsigned char* message, size_t) {
+        if (message[2] != CHANGE_EVENT_PARAMS_MSG) return;
+        std::int64_t set_time = set_times[message[4]][message[6]].exchange(-1);
+        if (set_time < 0) return;
+        std::lock_guard<std::mutex> lock(latency_mtx);
+        latencies.push_back(bench_clock.get_elapsed_time().as_microseconds() - set_time);
+    });
+    emulator.start();
+
+    Stimulator stim("Benchmark", stim_channels, board.get_slave_name(), "NONE", false);
+    if (!stim.create_scheduler(0xAA, 40) || !stim.add_events(stim_channels)) return 1;
+
+    // the board hands out the event ids, so ask it which event belongs to which channel
+    std::vector<unsigned char> event_ids(channels);
+    for (auto& event : emulator.get_events()) {
+        if (event.channel < channels) event_ids[event.channel] = event.id;
+    }
+    for (size_t i = 0; i < 256; i++) {
+        for (size_t j = 0; j < 256; j++) set_times[i][j] = -1;
+    }
+
+    stim.begin();
+    if (io_threaded) stim.start_io_threads();
+
+    Timer timer(microseconds((std::int64_t)(1e6 / rate)), Timer::WaitMode::Hybrid);
+    Clock run_clock;
+    Time  longest_update = Time::Zero;
+    for (size_t tick = 0; run_clock.get_elapsed_time() < seconds(duration); tick++) {
+        for (size_t i = 0; i < channels; i++) {
+            // a different amplitude every tick, so that every tick sends an update
+            unsigned int amplitude = 1 + (tick * channels + i) % 99;
+            set_times[event_ids[i]][amplitude] = bench_clock.get_elapsed_time().as_microseconds();
+            stim.set_amp(stim_channels[i], amplitude);
+        }
+        Clock update_clock;
+        if (!stim.update()) break;
+        if (update_clock.get_elapsed_time() > longest_update) longest_update = update_clock.get_elapsed_time();
+        timer.wait();
+    }
+    // give the last updates time to arrive
+    sleep(milliseconds(100));
+
+    stim.disable();
+    emulator.stop();
+
+    std::lock_guard<std::mutex> lock(latency_mtx);
+    if (latencies.empty()) {
+        LOG(Error) << "No updates made it to the board";
+        return 1;
+    }
+    std::sort(latencies.begin(), latencies.end());
+    std::int64_t p50_us = latencies[latencies.size() / 2];
+    std::int64_t p99_us = latencies[latencies.size() * 99 / 100];
+    std::int64_t max_us = latencies.back();
+    print_var(rate);
+    print_var(channels);
+    print_var(io_threaded);
+    print_var(latencies.size());
+    print_var(p50_us);
+    print_var(p99_us);
+    print_var(max_us);
+    print_var(longest_update.as_microseconds());
+    return 0;
+#endif
+}
@@ -0,0 +1,100 @@
+#include <Mahi/Fes.hpp>
+#include <Mahi/Util.hpp>
+#include <cstdio>
+
+using namespace mahi::util;
+using namespace mahi::fes;
+
+// records a few seconds of two channels against an emulated UECU, to have a session to replay
+bool record_session(const std::string& filename) {
+    std::vector<Channel> channels;
+    Channel bicep("Bicep", CH_1, AN_CA_1, 100, 250);
+    channels.push_back(bicep);
+    Channel tricep("Tricep", CH_2, AN_CA_2, 100, 250);
+    channels.push_back(tricep);
+
+    auto link = LoopbackTransport::make_pair("emulated");
+    std::unique_ptr<Transport> board = std::move(link.second);
+    board->open();
+    std::vector<std::unique_ptr<Transport>> transports;
+    transports.push_back(std::move(link.first));
+    // the capture is started before the stimulator enables, so the setup messages are in it too
+    Stimulator stim("Emulated UECU", channels, std::move(transports), false, filename);
+
+    UecuEmulator emulator(*board);
+    emulator.start();
+
+    if (!stim.is_enabled() || !stim.create_scheduler(0xAA, 40) || !stim.add_events(channels)) return false;
+    stim.begin();
+
+    Timer  timer(milliseconds(25), Timer::WaitMode::Hybrid);
+    double t = 0.0;
+    while (t < 2.0) {
+        stim.set_amp(bicep, 30 + int(20 * sin(t)));
+        stim.write_pw(bicep, 100);
+        stim.set_amp(tricep, 30 + int(20 * cos(t)));
+        stim.write_pw(tricep, 100);
+        if (!stim.update()) break;
+        t = timer.wait().as_seconds();
+    }
+    stim.disable();
+    stim.stop_capture();
+    emulator.stop();
+    return true;
+}
+
+int main(int argc, char* argv[]) {
+    // Replays the writes of a recorded session (see Stimulator::start_capture) into an emulated
+    // UECU over a pty and compares its replies with the recorded ones. The speed is 1 for the
+    // recorded timing, 10 for ten times as fast, or max to send as fast as the link takes it.
+    // eg. session_replay clinic.fescap max. With no file, a short session is recorded to
+    // fes_session.fescap first and replayed in real time
+#ifdef _WIN32
+    LOG(Error) << "Session replay is only available on Linux";
+    return 1;
+#else
+    std::string filename = "fes_session.fescap";
+    if (argc > 1) {
+        filename = argv[1];
+    } else if (!record_session(filename)) {
+        return 1;
+    }
+    double speed = 1.0;
+    if (argc > 2) speed = std::string(argv[2]) == "max" ? 0.0 : atof(argv[2]);
+
+    SessionReplay replay;
+    if (!replay.load(filename)) return 1;
+    replay.set_speed(speed);
+
+    // the emulator stands in for the board on the master end, and the replay writes to the slave
+    // end through the same serial port code the stimulator uses
+    PtyTransport board;
+    if (!board.open()) return 1;
+    UecuEmulator emulator(board);
+    emulator.start();
+    PosixTransport host(board.get_slave_name(), 9600);
+    if (!host.open()) return 1;
+
+    ReplayResult result = replay.run(host);
+    emulator.stop();
+
+    for (auto& diff : result.diffs) {
+        std::printf("reply %zu\n  recorded:", diff.index);
+        for (auto byte : diff.expected) std::printf(" %02X", (int)byte);
+        std::printf("\n  replayed:");
+        for (auto byte : diff.actual) std::printf(" %02X", (int)byte);
+        std::printf("\n");
+    }
+
+    print_var(result.writes);
+    print_var(result.bytes);
+    print_var(result.expected_replies);
+    print_var(result.received_replies);
+    print_var(result.matched);
+    print_var(result.mismatched);
+    print_var(result.recorded_duration.as_seconds());
+    print_var(result.replay_duration.as_seconds());
+    print_var(result.max_lag.as_microseconds());
+    return result.matches() ? 0 : 1;
+#endif
+}
@@ -65,6 +65,10 @@ int main() {
     // start sending stimulation to the board
     stim.begin();
 
+    // optionally, hand the serial writes off to one I/O thread per board. update() then no longer
+    // waits on the serial port, and set_amp/write_pw only post the latest values for the threads
+    // stim.start_io_threads();
+
     // set timer for our control loop
     Timer timer(milliseconds(25), Timer::WaitMode::Hybrid);
     timer.set_acceptable_miss_rate(0.05);
@@ -0,0 +1,75 @@
+#include <Mahi/Fes.hpp>
+#include <Mahi/Util.hpp>
+
+using namespace mahi::util;
+using namespace mahi::fes;
+
+// runs a stimulator with num_channels channels updated at control_rate Hz for 2 s of simulated
+// time, feeding everything it writes through the timing simulator
+UecuTimingSimStats simulate(size_t num_channels, double control_rate, double schedule_rate, const std::string& timeline_file) {
+    std::vector<Channel> all_channels = {Channel("Ch 1", CH_1, AN_CA_1, 100, 250), Channel("Ch 2", CH_2, AN_CA_2, 100, 250),
+                                         Channel("Ch 3", CH_3, AN_CA_3, 100, 250), Channel("Ch 4", CH_4, AN_CA_4, 100, 250)};
+    std::vector<Channel> channels(all_channels.begin(), all_channels.begin() + num_channels);
+
+    auto link = LoopbackTransport::make_pair("sim");
+    link.second->open();
+    Transport* host = link.first.get();
+
+    // the simulated clock only moves when the control loop says so, so this runs much faster than
+    // real time
+    UecuTimingSim sim(host->get_baud_rate());
+    Time          sim_time = Time::Zero;
+    host->set_tap([&sim, &sim_time](bool received, const unsigned char* data, size_t size) {
+        if (!received) sim.feed(sim_time, data, size);
+    });
+
+    std::vector<std::unique_ptr<Transport>> transports;
+    transports.push_back(std::move(link.first));
+    Stimulator stim("Simulated UECU", channels, std::move(transports), true);
+    if (!stim.create_scheduler(0xAA, schedule_rate) || !stim.add_events(channels)) {
+        LOG(Error) << "Could not set up the simulated schedule";
+        return UecuTimingSimStats();
+    }
+    stim.begin();
+
+    // change every channel every control period, the worst case for the link
+    Time period = microseconds((std::int64_t)(1e6 / control_rate));
+    for (int tick = 0; sim_time < seconds(2.0); tick++) {
+        for (size_t i = 0; i < channels.size(); i++) {
+            stim.set_amp(channels[i], 20 + (tick + i) % 40);
+        }
+        if (!stim.update()) {
+            LOG(Error) << "Update " << tick << " failed. Stopping the simulation";
+            break;
+        }
+        sim_time += period;
+    }
+    sim.finish(sim_time);
+    if (!timeline_file.empty()) sim.write_timeline(timeline_file);
+
+    stim.disable();
+    return sim.get_stats();
+}
+
+int main(int argc, char* argv[]) {
+    // Shows how many pulses fire with stale parameters for different control rates and channel
+    // counts on a 9600 baud link with a 40 Hz schedule. Pass a file name to also write the pulse
+    // timeline of the 4 channel, 100 Hz run as csv, eg. timing_sim timeline.csv
+    std::string timeline_file = argc > 1 ? argv[1] : "";
+
+    double control_rates[] = {10, 25, 40, 100, 200};
+    for (size_t channels = 1; channels <= 4; channels++) {
+        for (double rate : control_rates) {
+            UecuTimingSimStats stats = simulate(channels, rate, 40, channels == 4 && rate == 100 ? timeline_file : "");
+            // no pulses means the schedule never reached the simulator, so there is nothing to compare
+            if (stats.pulses == 0) {
+                LOG(Error) << channels << " channels at " << rate << " Hz: the simulated board fired no pulses. Check the log above";
+                return 1;
+            }
+            LOG(Info) << channels << " channels at " << rate << " Hz: " << stats.pulses << " pulses, " << stats.stale_pulses
+                      << " stale (" << 100 * stats.stale_pulses / stats.pulses << "%), oldest parameters "
+                      << stats.max_age.as_milliseconds() << " ms, longest time on the wire " << stats.max_arrival.as_milliseconds() << " ms";
+        }
+    }
+    return 0;
+}
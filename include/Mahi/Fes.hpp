@@ -18,12 +18,30 @@
 
 #include <Mahi/Fes/Core/Channel.hpp>
 #include <Mahi/Fes/Core/Event.hpp>
+#include <Mahi/Fes/Core/Frame.hpp>
+#include <Mahi/Fes/Core/LinkBudget.hpp>
 #include <Mahi/Fes/Core/Message.hpp>
 #include <Mahi/Fes/Core/ReadMessage.hpp>
 #include <Mahi/Fes/Core/Scheduler.hpp>
 #include <Mahi/Fes/Core/Stimulator.hpp>
-#include <Mahi/Fes/Core/WriteMessage.hpp>
+#include <Mahi/Fes/Transport/Capture.hpp>
+#include <Mahi/Fes/Transport/LoopbackTransport.hpp>
+#include <Mahi/Fes/Transport/Transport.hpp>
+#ifdef _WIN32
+#include <Mahi/Fes/Transport/Win32Transport.hpp>
+#else
+#include <Mahi/Fes/Transport/PosixTransport.hpp>
+#include <Mahi/Fes/Transport/PtyTransport.hpp>
+#endif
 #include <Mahi/Fes/Utility/Communication.hpp>
+#include <Mahi/Fes/Utility/PortWorker.hpp>
+#include <Mahi/Fes/Utility/ReplyDispatcher.hpp>
+#include <Mahi/Fes/Utility/ReplyParser.hpp>
+#include <Mahi/Fes/Utility/ReplyReader.hpp>
+#include <Mahi/Fes/Utility/SessionReplay.hpp>
+#include <Mahi/Fes/Utility/SpscQueue.hpp>
+#include <Mahi/Fes/Utility/UecuEmulator.hpp>
+#include <Mahi/Fes/Utility/UecuTimingSim.hpp>
 #include <Mahi/Fes/Utility/Utility.hpp>
 #include <Mahi/Fes/Utility/VirtualStim.hpp>
 #include <Mahi/Fes/Utility/Visualizer.hpp>
\ No newline at end of file
@@ -16,8 +16,7 @@
 
 #pragma once
 
-#include <Windows.h>
-
+#include <Mahi/Fes/Transport/Transport.hpp>
 #include <Mahi/Util.hpp>
 #include <string>
 
@@ -51,7 +50,7 @@ public:
     /// Channel destructor
     ~Channel();
     /// writes the channel setup command to the UECU given the constructor parameters.
-    bool setup_channel(HANDLE serial_handle_, mahi::util::Time delay_time_);
+    bool setup_channel(Transport& transport_, mahi::util::Time delay_time_);
     /// return the max amplitude allowed by the channel
     unsigned int get_max_amplitude();
     /// return the max pulsewidth allowed by the channel
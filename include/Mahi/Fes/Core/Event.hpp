@@ -17,9 +17,10 @@
 #pragma once
 
 #include <Mahi/Fes/Core/Channel.hpp>
+#include <Mahi/Fes/Core/Frame.hpp>
+#include <Mahi/Fes/Utility/Utility.hpp>
+#include <vector>
 
-#define DELETE_EVENT_LEN        0x01
-#define CHANGE_EVENT_PARAMS_LEN 0x04
 #define STIM_EVENT              0x03
 
 namespace mahi {
@@ -28,12 +29,12 @@ namespace fes {
 /// An event controls what happens on a single channel in the scheduler. The scheduler must
 /// be created before an event can be added, because the event is takes the schedule id as
 /// a parameter. The event is the underlying mechanism that controls any real-time control,
-/// as parameters are changed using set_{parameter}, and update sends a message to the UECU
-/// with the actual update.
+/// as parameters are changed using set_{parameter}, and append_update adds the message with the
+/// actual update to the ones the scheduler sends to the UECU.
 class Event {
 public:
     /// Event constructor
-    Event(HANDLE& hComm, unsigned char schedule_id_, int delay_time_, Channel channel_, unsigned char event_id_,
+    Event(Transport* transport_, unsigned char schedule_id_, int delay_time_, Channel channel_, unsigned char event_id_,
           bool is_virtual_, unsigned int pulse_width_ = 0, unsigned int amplitude_ = 0,
           unsigned char event_type_ = STIM_EVENT, unsigned char priority_ = 0x00, unsigned char zone_ = 0x00);
     /// Event destructor
@@ -42,12 +43,24 @@ public:
     bool create_event();
     /// Sends the message to the UECU to delete the event
     bool delete_event();
-    /// Sends the edit event message given the current amplitude and pulsewidth values
-    bool update();
+    /// Sends the message to the UECU to move the event to delay_time_ ms into each schedule period
+    bool change_delay_time(unsigned int delay_time_);
+    /// Appends the edit event message to buffer_ if the amplitude or pulsewidth changed since the
+    /// last update. Nothing is written to the UECU. returns whether a message was appended
+    bool append_update(std::vector<unsigned char>& buffer_);
+    /// Same as above, but for the given pulsewidth and amplitude rather than the ones last set on
+    /// this event. Used by the I/O thread, which takes its values from the scheduler's mailbox
+    bool append_update(std::vector<unsigned char>& buffer_, unsigned int pulse_width_, unsigned int amplitude_);
     /// returns the current amplitude
     unsigned int get_amplitude();
     /// returns the current pulsewidth
     unsigned int get_pulsewidth();
+    /// returns the delay time (ms) of the event from the beginning of each schedule period
+    unsigned int get_delay_time();
+    /// returns the max amplitude allowed for the event
+    unsigned int get_max_amplitude();
+    /// returns the max pulsewidth allowed for the event
+    unsigned int get_max_pulsewidth();
     /// returns the channel attached to this event
     Channel get_channel();
     /// returns the channel number of the channel attached to this event
@@ -62,7 +75,7 @@ public:
     void set_event_id(unsigned char event_id);
 
 private:
-    HANDLE        m_hComm;            // serial handle to the appropriate UECU
+    Transport*    m_transport;        // transport to the appropriate UECU
     unsigned char m_schedule_id;      // schedule id of the associated schedule
     unsigned int  m_delay_time;       // delay time from the beginning of the schedule (all events should be different)
     Channel       m_channel;          // channel attached to the event
@@ -77,6 +90,7 @@ private:
     unsigned int  m_max_pulse_width;  // max pulse width allowed for the event
     unsigned char m_zone;             // unused (should be 0x00)
     bool          m_is_virtual;       // determines whether or not to wait for return messages
+    ChangeEventParamsFrame m_params_frame;  // edit event message, patched with the new values on each update
 };
 }  // namespace fes
 }  // namespace mahi
@@ -0,0 +1,197 @@
+// MIT License
+//
+// Copyright (c) 2020 Mechatronics and Haptic Interfaces Lab - Rice University
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// Author(s): Nathan Dunkelberger (nbd2@rice.edu)
+
+#pragma once
+
+#include <Mahi/Fes/Transport/Transport.hpp>
+#include <Mahi/Fes/Utility/Utility.hpp>
+#include <array>
+#include <cstddef>
+#include <vector>
+
+#define FRAME_HEADER_SIZE   4  // destination, source, message type and message length
+#define FRAME_CHECKSUM_SIZE 1  // checksum at the end of every message
+
+namespace mahi {
+namespace fes {
+
+/// Structure of byte arrays:
+///  Destination address - always 0x04
+///  Source address - always 0x80
+///  Message type - see message commands in Utility.hpp
+///  Message Length - length of message without header (everything up to msg length) or checksum
+///  Message - Bytes of the message - must be of length Message Length
+///  Checksum Calculation - add each of the bytes, mask the lower byte of sum and add cary byte,
+///  then invert sum
+
+/// computes the checksum of the size_ bytes of a message that come before its checksum
+unsigned char frame_checksum(const unsigned char* data_, size_t size_);
+
+/// sums the bytes of a message (see checksum_of)
+constexpr unsigned int byte_sum() { return 0; }
+template <typename... Bytes>
+constexpr unsigned int byte_sum(unsigned char first_, Bytes... rest_) { return first_ + byte_sum(rest_...); }
+
+/// turns the sum of the bytes of a message into its checksum
+constexpr unsigned char checksum_of_sum(unsigned int sum_) { return (unsigned char)(((sum_ & 0xFF) + (sum_ >> 8)) ^ 0xFF); }
+
+/// same as frame_checksum, but for bytes passed one by one, so that the checksum of a message
+/// that is known when compiling is worked out by the compiler
+template <typename... Bytes>
+constexpr unsigned char checksum_of(Bytes... bytes_) {
+    return checksum_of_sum(byte_sum(bytes_...));
+}
+/// writes size_ bytes of a complete message to transport_, logging activity_ unless it is "NONE".
+/// Stop messages (halts, deletes, etc.) should be written with priority
+bool write_frame(Transport& transport_, const unsigned char* data_, size_t size_, const char* activity_,
+                 bool priority_ = false);
+
+/// A complete message to the UECU of type Type with Length bytes of data, held in a fixed size
+/// array so that building one never allocates. The typed frames below fill in the data, and the
+/// header and checksum are filled in here. The number of data bytes a frame passes in is checked
+/// against Length when it is compiled. Every frame can be built as a constexpr, in which case the
+/// whole message, checksum included, is worked out when compiling, eg.
+///     constexpr SyncFrame sync(0xAA);
+/// Frames that depend on values only known once the board is set up (schedule ids, etc.) are
+/// best built once and kept, so that sending one is a single write of ready-made bytes.
+template <unsigned char Type, size_t Length>
+class Frame {
+public:
+    static_assert(Length <= 0xFF, "the message length must fit in one byte");
+
+    /// returns the size of the whole message, including header and checksum
+    static constexpr size_t size() { return FRAME_HEADER_SIZE + Length + FRAME_CHECKSUM_SIZE; }
+    /// returns a pointer to the first byte of the message
+    const unsigned char* data() const { return m_bytes.data(); }
+    /// returns the checksum of the message
+    unsigned char get_checksum() const { return m_bytes[size() - 1]; }
+    /// appends the complete message to buffer_ so several messages can be sent with a single write
+    void append_to(std::vector<unsigned char>& buffer_) const {
+        buffer_.insert(buffer_.end(), m_bytes.begin(), m_bytes.end());
+    }
+    /// writes the message to the given transport (see write_frame)
+    bool write(Transport& transport_, const char* activity_, bool priority_ = false) const {
+        return write_frame(transport_, data(), size(), activity_, priority_);
+    }
+
+protected:
+    /// fills in the header, the data bytes given, and the checksum
+    template <typename... Bytes>
+    constexpr explicit Frame(Bytes... data_) :
+        m_bytes{{DEST_ADR, SRC_ADR, Type, (unsigned char)Length, (unsigned char)data_...,
+                 checksum_of(DEST_ADR, SRC_ADR, Type, Length, (unsigned char)data_...)}} {
+        static_assert(sizeof...(Bytes) == Length, "the number of data bytes does not match the message length");
+    }
+
+    std::array<unsigned char, FRAME_HEADER_SIZE + Length + FRAME_CHECKSUM_SIZE> m_bytes;  // the whole message
+};
+
+/// Sets the amplitude and pulsewidth limits, interphase delay, aspect and electrodes of a channel
+struct ChannelSetupFrame : Frame<CHANNEL_SETUP_MSG, CH_SET_LEN> {
+    constexpr ChannelSetupFrame(unsigned char channel_, unsigned char amp_limit_, unsigned char pw_limit_,
+                                          unsigned int ip_delay_, unsigned char aspect_, unsigned char an_ca_) :
+        Frame(channel_, amp_limit_, pw_limit_, ip_delay_ >> 8, ip_delay_, aspect_, an_ca_) {}
+};
+
+/// Creates a schedule that is started by sync_char_ and repeats every duration_ ms
+struct CreateScheduleFrame : Frame<CREATE_SCHEDULE_MSG, CREATE_SCHED_LEN> {
+    constexpr CreateScheduleFrame(unsigned char sync_char_, unsigned int duration_) :
+        Frame(sync_char_, duration_ >> 8, duration_) {}
+};
+
+/// Changes the sync character and period of an existing schedule. The board starts the new period
+/// at the end of the one in progress
+struct ChangeScheduleFrame : Frame<CHANGE_SCHEDULE_MSG, CHANGE_SCHED_LEN> {
+    constexpr ChangeScheduleFrame(unsigned char schedule_id_, unsigned char sync_char_, unsigned int duration_) :
+        Frame(schedule_id_, sync_char_, duration_ >> 8, duration_) {}
+};
+
+/// Stops (running_ = false) or restarts a schedule, keeping it and its events on the board. The
+/// protocol document does not give the values of the State byte, so 0x00 (stopped) and 0x01
+/// (running) are assumed here and need checking against a board
+struct ChangeScheduleStateFrame : Frame<CHANGE_SCHEDULE_STATE_MSG, CHANGE_SCHED_STATE_LEN> {
+    constexpr ChangeScheduleStateFrame(unsigned char schedule_id_, bool running_) :
+        Frame(schedule_id_, running_ ? 0x01 : 0x00) {}
+};
+
+/// Creates an event on a schedule, delay_ ms after the start of each period
+struct CreateEventFrame : Frame<CREATE_EVENT_MSG, CR_EVT_LEN> {
+    constexpr CreateEventFrame(unsigned char schedule_id_, unsigned int delay_, unsigned char priority_,
+                               unsigned char event_type_, unsigned char channel_, unsigned char pulse_width_,
+                               unsigned char amplitude_, unsigned char zone_) :
+        Frame(schedule_id_, delay_ >> 8, delay_, priority_, event_type_, channel_, pulse_width_, amplitude_,
+              zone_) {}
+};
+
+/// Moves an event to delay_ ms after the start of each period of a schedule
+struct ChangeEventScheduleFrame : Frame<CHANGE_EVENT_SCHED_MSG, CHANGE_EVENT_SCHED_LEN> {
+    constexpr ChangeEventScheduleFrame(unsigned char event_id_, unsigned char schedule_id_, unsigned int delay_,
+                                       unsigned char priority_) :
+        Frame(event_id_, schedule_id_, delay_ >> 8, delay_, priority_) {}
+};
+
+/// Changes the pulsewidth and amplitude of an event. An event keeps one of these and only
+/// changes the two values in it, rather than building a new one for every update
+struct ChangeEventParamsFrame : Frame<CHANGE_EVENT_PARAMS_MSG, CHANGE_EVENT_PARAMS_LEN> {
+    constexpr ChangeEventParamsFrame(unsigned char event_id_, unsigned char pulse_width_, unsigned char amplitude_) :
+        Frame(event_id_, pulse_width_, amplitude_, 0x00),
+        m_sum(byte_sum(DEST_ADR, SRC_ADR, CHANGE_EVENT_PARAMS_MSG, CHANGE_EVENT_PARAMS_LEN, event_id_, pulse_width_,
+                       amplitude_, 0x00)) {}
+
+    /// changes the pulsewidth and amplitude in place. The checksum is worked out from how much
+    /// the sum of the bytes changed, so no other byte is looked at
+    void set_params(unsigned char pulse_width_, unsigned char amplitude_) {
+        m_sum = m_sum - m_bytes[PW_BYTE] - m_bytes[AMP_BYTE] + pulse_width_ + amplitude_;
+        m_bytes[PW_BYTE]    = pulse_width_;
+        m_bytes[AMP_BYTE]   = amplitude_;
+        m_bytes[size() - 1] = checksum_of_sum(m_sum);
+    }
+
+private:
+    enum { PW_BYTE = FRAME_HEADER_SIZE + 1, AMP_BYTE = FRAME_HEADER_SIZE + 2 };  // where the values sit
+
+    unsigned int m_sum;  // sum of every byte before the checksum
+};
+
+/// Runs a single stimulus event on a channel right away, outside of any schedule
+struct StimEventCommandFrame : Frame<EVENT_COMMAND_MSG, STIM_EVENT_COMMAND_LEN> {
+    constexpr StimEventCommandFrame(unsigned char priority_, unsigned char channel_, unsigned char pulse_width_,
+                                    unsigned char amplitude_, unsigned char zone_) :
+        Frame(STIM_EVENT, priority_, channel_, pulse_width_, amplitude_, zone_) {}
+};
+
+/// Starts every schedule that was created with sync_char_
+struct SyncFrame : Frame<SYNC_MSG, SYNC_MSG_LEN> {
+    constexpr explicit SyncFrame(unsigned char sync_char_) : Frame(sync_char_) {}
+};
+
+/// Halts a schedule, stopping all of its events
+struct HaltFrame : Frame<HALT_MSG, HALT_LEN> {
+    constexpr explicit HaltFrame(unsigned char schedule_id_) : Frame(schedule_id_) {}
+};
+
+/// Deletes an event
+struct DeleteEventFrame : Frame<DELETE_EVENT_MSG, DELETE_EVENT_LEN> {
+    constexpr explicit DeleteEventFrame(unsigned char event_id_) : Frame(event_id_) {}
+};
+
+/// Deletes a schedule
+struct DeleteScheduleFrame : Frame<DELETE_SCHEDULE_MSG, DEL_SCHED_LEN> {
+    constexpr explicit DeleteScheduleFrame(unsigned char schedule_id_) : Frame(schedule_id_) {}
+};
+
+}  // namespace fes
+}  // namespace mahi
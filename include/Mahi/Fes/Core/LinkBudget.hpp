@@ -0,0 +1,55 @@
+// MIT License
+//
+// Copyright (c) 2020 Mechatronics and Haptic Interfaces Lab - Rice University
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// Author(s): Nathan Dunkelberger (nbd2@rice.edu)
+
+#pragma once
+
+#include <Mahi/Util.hpp>
+#include <cstddef>
+
+#define CHANGE_EVENT_PARAMS_SIZE 9  // bytes on the wire for one event update (header, 4 params, checksum)
+
+namespace mahi {
+namespace fes {
+
+/// What to do when the event updates of a board do not fit on its serial link within one
+/// schedule period
+enum class LinkPolicy {
+    Refuse,      // refuse to add events beyond what fits
+    LowerRate,   // send every update, but only once every few schedule periods
+    RoundRobin   // send as many updates as fit each period, taking turns between the events
+};
+
+/// How the worst case traffic of one board (every event changing every period) compares to
+/// what its serial link can carry in one schedule period
+struct LinkBudget {
+    mahi::util::Time period;              // schedule period
+    mahi::util::Time wire_time;           // time to send an update for every event
+    size_t           events          = 0; // number of events
+    size_t           events_per_tick = 0; // number of event updates that fit in one period
+    size_t           rate_divider    = 1; // periods needed to send an update for every event
+    double           headroom        = 0; // fraction of the period left over (negative when over)
+    bool             valid           = true; // false for a period or baud rate of 0, where nothing can be sent
+
+    /// returns whether an update for every event fits in one period
+    bool fits() const { return valid && events <= events_per_tick; }
+};
+
+/// computes the link budget of num_events_ events at the given baud rate and schedule period. A
+/// period or baud rate of 0 gives a budget that is not valid and never fits
+LinkBudget compute_link_budget(unsigned int baud_rate_, unsigned int period_ms_, size_t num_events_);
+
+}  // namespace fes
+}  // namespace mahi
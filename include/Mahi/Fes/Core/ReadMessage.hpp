@@ -18,6 +18,7 @@
 
 #include <Mahi/Fes/Core/Message.hpp>
 #include <Mahi/Fes/Utility/Utility.hpp>
+#include <cstdint>
 
 namespace mahi {
 namespace fes {
@@ -25,6 +26,24 @@ namespace fes {
 #define CRC_SEED 0xFFFF  // seed value for doing the crc calculation
 #define CRC_POLY 0xA001  // poly value for doing the crc calculation
 
+/// crc of every byte value, so the crc takes one lookup per byte rather than one step per bit
+extern const std::uint16_t CRC_TABLE[256];
+
+/// adds one more byte to a crc that is being calculated as the bytes arrive. Start from CRC_SEED
+inline unsigned int update_crc(unsigned int crc_, unsigned char byte_) {
+    return (crc_ >> 8) ^ CRC_TABLE[(crc_ ^ byte_) & 0xFF];
+}
+/// adds size_ more bytes of data_ to a crc that is being calculated as the bytes arrive
+unsigned int update_crc(unsigned int crc_, const unsigned char* data_, size_t size_);
+/// calculates the cyclic redundancy check of size_ bytes of data_ as the UECU does
+unsigned int calc_crc(const unsigned char* data_, size_t size_);
+/// checks the crc at the end of each of count_ replies (replies_[i] holding sizes_[i] bytes, crc
+/// included), for scanning through many replies at once, eg. from a capture. valid_[i] is set to
+/// whether reply i matched its crc. returns the number that matched
+size_t check_crcs(const unsigned char* const* replies_, const size_t* sizes_, size_t count_, bool* valid_);
+/// returns whether type_ is one of the messages the UECU sends back
+bool is_reply_type(unsigned char type_);
+
 /// The UECU was originally designed to work with a device called the Amulet. Because
 /// of this, some of the information in these messages are not important. So anything
 /// starting with the word Amulet is not important for our use, except in reading the
@@ -45,6 +64,8 @@ public:
     ReadMessage(std::vector<unsigned char> message, size_t msg_count);
     /// calculate the cyclic redundancy check for the given message
     std::vector<unsigned char> calc_crc();
+    /// returns whether the crc at the end of the message matches the message
+    bool crc_matches();
     /// returns the message data (without header or crc)
     std::vector<unsigned char> get_data();
     /// returns the type of the message as an unsigned char
@@ -56,13 +77,47 @@ public:
     unsigned char              m_read_message_type;  // the type of message-refer to utility.hpp for msg types
     std::vector<unsigned char> m_crc;                // the unsigned char values of the crc
 
-    std::vector<unsigned char> valid_msg_types = {ERROR_REPORT_MSG, EVENT_ERROR_MSG, CREATE_SCHEDULE_REPLY_MSG,
-                                                  CREATE_EVENT_REPLY_MSG,
-                                                  EVENT_COMMAND_REPLY_MSG};  // list of message types that can be sent
-
 private:
     std::vector<unsigned char> m_data;  // message data (without header or crc)
 };
 
+/// A reply read in place from the buffer it was received into, rather than copied out of it like
+/// ReadMessage does. The layout is the same as ReadMessage. The view does not own the bytes, so it
+/// is only good for as long as the buffer holds them; use to_message for a reply that has to be
+/// kept.
+class ReadMessageView {
+public:
+    /// ReadMessageView constructor for an empty view (eg. when nothing was read)
+    ReadMessageView();
+    /// ReadMessageView constructor for the size_ bytes of a whole reply at message_
+    ReadMessageView(const unsigned char* message_, size_t size_);
+    /// returns whether the view holds no reply
+    bool empty() const;
+    /// returns a pointer to the whole reply, including header and crc
+    const unsigned char* get_message_pointer() const;
+    /// returns the size of the whole reply, including header and crc
+    size_t get_size() const;
+    /// returns the type of the reply
+    unsigned char get_read_message_type() const;
+    /// returns a pointer to the reply data (without header or crc)
+    const unsigned char* get_data() const;
+    /// returns the number of data bytes
+    size_t get_data_size() const;
+    /// returns the crc sent at the end of the reply
+    unsigned int get_crc() const;
+    /// returns whether the crc at the end of the reply matches the reply
+    bool crc_matches() const;
+    /// checks if the reply is valid according to crc and type
+    bool is_valid() const;
+    /// returns a copy of the whole reply (eg. for print_message)
+    std::vector<unsigned char> get_message() const;
+    /// returns a copy of the reply that owns its bytes
+    ReadMessage to_message() const;
+
+private:
+    const unsigned char* m_message;  // the whole reply, in the buffer it was received into
+    size_t               m_size;     // size of the whole reply
+};
+
 }  // namespace fes
 }  // namespace mahi
\ No newline at end of file
@@ -18,11 +18,16 @@
 
 #include <Mahi/Fes/Core/Channel.hpp>
 #include <Mahi/Fes/Core/Event.hpp>
+#include <Mahi/Fes/Core/Frame.hpp>
+#include <Mahi/Fes/Core/LinkBudget.hpp>
 #include <Mahi/Util.hpp>
+#include <atomic>
+#include <cstdint>
+#include <thread>
 #include <vector>
 
-#define DEL_SCHED_LEN 0x01
-#define STIM_EVENT    0x03
+#define STIM_EVENT       0x03
+#define MAX_SCHED_EVENTS 4  // each board (and therefore each scheduler) has 4 channels
 
 namespace mahi {
 namespace fes {
@@ -34,7 +39,7 @@ public:
     /// Scheduler destructor
     ~Scheduler();
     /// creates the scheduler object
-    bool create_scheduler(HANDLE& hComm_, const unsigned char sync_msg, unsigned int duration,
+    bool create_scheduler(Transport& transport_, const unsigned char sync_msg, unsigned int duration,
                           mahi::util::Time setup_time);
     /// add an event to the stimulator, and sleep for a short time to let the UECU process
     bool add_event(Channel channel_, mahi::util::Time sleep_time, bool is_virtual_,
@@ -55,25 +60,136 @@ public:
     void write_pw(Channel channel_, unsigned int pw_);
     /// return the pulsewidth value of a specified channel
     unsigned int get_pw(Channel channel_);
+    /// move the event of a specified channel to delay_time_ ms into each period of the running
+    /// schedule. The delay must fit in the period and differ from that of every other event
+    bool set_delay_time(Channel channel_, unsigned int delay_time_);
+    /// return the delay time (ms) of the event of a specified channel
+    unsigned int get_delay_time(Channel channel_);
+    /// check whether the events of the running schedule can be moved to spacing_ ms apart. The
+    /// spacing must be at least 1 ms and the last event must still start within the period.
+    /// Nothing is sent to the UECU
+    bool check_event_spacing(unsigned int spacing_);
+    /// move the events of the running schedule to spacing_ ms apart, the first at the start of the
+    /// period, in the order they were added. Events added later keep the same spacing (5 ms by
+    /// default). See check_event_spacing for what is allowed
+    bool set_event_spacing(unsigned int spacing_);
+    /// return the delay times (ms) of the events, in the order they were added
+    std::vector<unsigned int> get_delay_times();
+    /// move the events of the running schedule to delay_times_ (ms, one per event in the order they
+    /// were added) and give events added later spacing_. If an event can not be moved, the ones
+    /// already moved are put back and nothing changes. Used to undo set_event_spacing
+    bool set_delay_times(const std::vector<unsigned int>& delay_times_, unsigned int spacing_);
+    /// return the spacing (ms) given to the events
+    unsigned int get_event_spacing();
     /// return the number of events attached to the scheduler
     size_t get_num_events();
     /// return the vector of events for the scheduler
-    std::vector<Event> get_events();
-    /// send the message to halt the scheduler -> stopping all events attached to it
+    std::vector<Event>& get_events();
+    /// send the message to halt the scheduler -> stopping all events attached to it. The message
+    /// goes out ahead of any event updates still waiting in the transport (see Transport)
     bool halt_scheduler();
-    /// command each of the events to write it's current pw and amplitude to the
+    /// stop the schedule without deleting it or its events, so that resume can restart it right
+    /// away. Like the halt, the message goes out ahead of event updates waiting in the transport. Updates sent
+    /// while paused are kept by the board for when the schedule is resumed
+    bool pause();
+    /// restart a paused schedule. Like the pause, the message goes out ahead of event updates
+    /// waiting in the transport. The board starts a new period
+    bool resume();
+    /// return whether the schedule is paused
+    bool is_paused();
+    /// command each of the events to write it's current pw and amplitude to the UECU. All
+    /// events that changed are sent together in a single write to the transport, except for
+    /// events set to zero amplitude, which are sent first through the transport's priority lane
     bool update();
+    /// return the number of event messages sent by the last update, or by the I/O thread since
+    /// it was started
+    size_t get_update_count();
     /// send the sync message to start commanding the events attached to it
     bool send_sync_msg();
     /// return whether or not the scheduler is enabled
     bool is_enabled();
+    /// return the schedule duration (ms)
+    unsigned int get_duration();
+    /// return whether the running schedule can be changed to duration_ ms: the duration must be
+    /// longer than the delay of every event, and fit the link budget under LinkPolicy::Refuse.
+    /// Nothing is sent to the UECU
+    bool check_duration(unsigned int duration_);
+    /// change the schedule duration (ms) of the running schedule, keeping its events. The board
+    /// starts the new period at the end of the one in progress. See check_duration for what is
+    /// allowed
+    bool set_duration(unsigned int duration_);
+    /// start a thread that sends the latest pw and amplitude of each event to the UECU once every
+    /// schedule period. While it runs, set_amp/write_pw only post to a mailbox and never block
+    bool start_io_thread();
+    /// stop the I/O thread, if it is running
+    void stop_io_thread();
+    /// return whether the I/O thread is running
+    bool is_io_threaded();
+    /// return whether the I/O thread failed to write
+    bool io_failed();
+    /// set what to do when the event updates do not fit on the link (RoundRobin by default)
+    void set_link_policy(LinkPolicy link_policy_);
+    /// return what is done when the event updates do not fit on the link
+    LinkPolicy get_link_policy();
+    /// return how the worst case traffic of the current events compares to the link capacity
+    LinkBudget get_link_budget();
+    /// set how many bytes may still be waiting to go out on the link when an update is sent. While
+    /// more are waiting, updates are held back, and once the link catches up only the latest values
+    /// are sent. 0 never holds updates back. (one event update, CHANGE_EVENT_PARAMS_SIZE, by default)
+    void set_max_queued(size_t max_queued_);
+    /// return how many updates were held back because the link had not caught up yet
+    size_t get_held_back_count();
+    /// return the time from the last stop (halt, or events set to zero amplitude) being requested
+    /// to its last byte going out on the wire
+    mahi::util::Time get_stop_latency();
 
 private:
+    /// posts the current pw and amplitude of event event_index_ for the I/O thread
+    void post(size_t event_index_);
+    /// loop run by the I/O thread
+    void io_loop();
+    /// fills the update buffer with the messages of changed events, as far as the link policy
+    /// allows, taking the values from the mailbox if from_mailbox_. returns the number of messages
+    size_t collect_updates(bool from_mailbox_);
+    /// returns whether more than the allowed number of bytes are still waiting to go out on the link
+    bool link_backed_up();
+    /// sends the messages of events that were set to zero amplitude through the priority lane,
+    /// taking the values from the mailbox if from_mailbox_. stop_count_ is set to the number of
+    /// messages sent. returns false if the write failed
+    bool send_stops(bool from_mailbox_, size_t& stop_count_);
+    /// records the latency of a stop requested at stop_time_ (on m_clock) that was just written
+    void record_stop(mahi::util::Time stop_time_);
+
     unsigned char      m_id;         // the schedule id
     std::vector<Event> m_events;     // vector of events for the current scheduler
     bool               m_enabled;    // value indicating whether the scheduler is currently enabled
-    HANDLE             m_hComm;      // serial handle to the appropriate UECU
+    bool               m_paused;     // value indicating whether the schedule was paused
+    Transport*         m_transport;  // transport to the appropriate UECU
     unsigned char      m_sync_char;  // sync message for the scheduler which tells it to begin
+    SyncFrame                  m_sync_frame;       // sync message, encoded once the sync character is known
+    HaltFrame                  m_halt_frame;       // halt message, encoded once the schedule id is known
+    DeleteScheduleFrame        m_del_sched_frame;  // delete schedule message, encoded once the schedule id is known
+    ChangeScheduleStateFrame   m_pause_frame;      // pause message, encoded once the schedule id is known
+    ChangeScheduleStateFrame   m_resume_frame;     // resume message, encoded once the schedule id is known
+    std::vector<unsigned char> m_update_buffer;  // messages from every changed event, sent together on update
+    std::vector<unsigned char> m_stop_buffer;    // messages of events set to zero amplitude, sent first
+    std::atomic<size_t>        m_update_count;   // number of event messages sent by the last update
+    unsigned int               m_duration;       // schedule duration (ms)
+    unsigned int               m_event_spacing;  // time between the delays of consecutive events (ms)
+    LinkPolicy                 m_link_policy;    // what to do when the event updates do not fit on the link
+    LinkBudget                 m_budget;         // link budget of the current events
+    size_t                     m_tick;           // number of updates so far, used to skip periods
+    size_t                     m_next_event;     // event to look at first on the next update
+    size_t                     m_max_queued;     // bytes allowed in the transmit queue when sending updates
+    std::atomic<size_t>        m_held_back_count;  // number of updates held back for a backed up link
+    mahi::util::Clock          m_clock;            // time base for stop requests
+    std::atomic<std::int64_t>  m_stop_request;     // time a zero amplitude was last set, -1 once sent (us)
+    std::atomic<std::int64_t>  m_stop_latency;     // latency of the last stop (us)
+
+    std::atomic<std::uint32_t> m_mailbox[MAX_SCHED_EVENTS];  // latest pw/amp posted per event, flagged until sent
+    std::thread                m_io_thread;                  // thread that drains the mailbox onto the transport
+    std::atomic<bool>          m_io_running;                 // whether the I/O thread should keep running
+    std::atomic<bool>          m_io_failed;                  // set by the I/O thread when something went wrong
 };
 }  // namespace fes
 }  // namespace mahi
\ No newline at end of file
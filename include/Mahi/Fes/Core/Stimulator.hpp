@@ -16,12 +16,20 @@
 
 #pragma once
 
-#include <Windows.h>
-
 #include <Mahi/Fes/Core/Channel.hpp>
+#include <Mahi/Fes/Core/Frame.hpp>
 #include <Mahi/Fes/Core/ReadMessage.hpp>
 #include <Mahi/Fes/Core/Scheduler.hpp>
+#include <Mahi/Fes/Transport/Capture.hpp>
+#include <Mahi/Fes/Transport/Transport.hpp>
+#include <Mahi/Fes/Utility/PortWorker.hpp>
+#include <Mahi/Fes/Utility/ReplyDispatcher.hpp>
+#include <Mahi/Fes/Utility/ReplyReader.hpp>
 #include <Mahi/Fes/Utility/Utility.hpp>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
 #include <mutex>
 #include <queue>
 #include <string>
@@ -29,10 +37,39 @@
 
 namespace mahi {
 namespace fes {
+
+/// What the last call to Stimulator::update put on the wire, summed over all ports. When the I/O
+/// threads are running, this is what they sent and received since the previous update
+struct UpdateStats {
+    size_t        messages      = 0;  // number of event messages sent
+    std::uint64_t bytes_written = 0;  // bytes written to the boards
+    std::uint64_t bytes_read    = 0;  // bytes read back from the boards
+    std::uint64_t write_calls   = 0;  // device write calls issued
+    std::uint64_t read_calls    = 0;  // device read calls issued
+    size_t        held_back     = 0;  // updates held back because a link had not caught up yet
+};
+
+/// Pulses fired with Stimulator::fire, kept apart from the periodic updates. The latencies are
+/// estimates: the time until the pulse was handed to the link, plus the bytes the link still had
+/// queued at that point at its byte time
+struct FireStats {
+    std::uint64_t    commands        = 0;                       // event commands sent
+    std::uint64_t    replies         = 0;                       // event command replies matched to the command they answer
+    std::uint64_t    unanswered      = 0;                       // event commands that got no reply within the reply timeout
+    std::uint64_t    unmatched       = 0;                       // event command replies that answer no command that was sent
+    mahi::util::Time est_latency     = mahi::util::Time::Zero;  // estimated trigger to wire of the last pulse
+    mahi::util::Time max_est_latency = mahi::util::Time::Zero;  // longest estimated trigger to wire so far
+};
+
 class Stimulator {
 public:
-    /// Stimulator constructor
-    Stimulator(const std::string& name_, std::vector<Channel>& channels_,  const std::string& com_port_1_,  const std::string& com_port_2_ = "NONE", bool is_virtual_ = false);
+    /// Stimulator constructor. Unless capture_file_ is "NONE", a capture to that file (see
+    /// start_capture) is started before enabling, so it includes the setup messages
+    Stimulator(const std::string& name_, std::vector<Channel>& channels_,  const std::string& com_port_1_,  const std::string& com_port_2_ = "NONE", bool is_virtual_ = false, const std::string& capture_file_ = "NONE");
+    /// Stimulator constructor for already created transports (one per board, at most two). The
+    /// stimulator takes ownership of the transports and opens them when enabled. capture_file_ is
+    /// the same as above
+    Stimulator(const std::string& name_, std::vector<Channel>& channels_, std::vector<std::unique_ptr<Transport>> transports_, bool is_virtual_ = false, const std::string& capture_file_ = "NONE");
     /// Stimulator destructor
     ~Stimulator();
     /// open, configure, and initialize the serial communication for use with the board
@@ -42,6 +79,15 @@ public:
     /// takes the scheduler objet that already exists and sends the create_scheduler message
     /// to the UECU, assigning scheduler id in the process
     bool create_scheduler(const unsigned char sync_msg, double frequency_);
+    /// change the stimulation frequency (Hz) of the running schedulers without stopping them or
+    /// recreating their events. Each board starts the new period at the end of the one in progress
+    bool set_frequency(double frequency_);
+    /// move the event of a single channel to delay_time_ ms into each schedule period, without
+    /// stopping the schedule
+    bool set_delay_time(Channel channel_, unsigned int delay_time_);
+    /// move the events on every board to spacing_ ms apart within each schedule period (eg. to
+    /// pack them tighter before raising the frequency), without stopping the schedules
+    bool set_event_spacing(unsigned int spacing_);
     /// checks whether the stimulator has been enabled
     bool is_enabled();
     /// set the amplitude for a single channel (event). This runs down to the event object
@@ -64,12 +110,81 @@ public:
     std::vector<Channel> get_channels();
     /// start the stimulator by sending the sync message
     bool begin();
-    /// command values set by set_amp/pw commands by sending messages to the UECU
+    /// command values set by set_amp/pw commands by sending messages to the UECU. When the I/O
+    /// threads are running, the messages are sent by them and this only checks that they are healthy
     bool update();
+    /// start one I/O thread per board. From then on set_amp/write_pw only post the new values, and
+    /// the threads send them once every schedule period. Call after create_scheduler and add_events
+    bool start_io_threads();
+    /// stop the I/O threads and go back to sending messages on update
+    void stop_io_threads();
+    /// return whether the I/O threads are running
+    bool is_io_threaded();
+    /// start the background reply reader for each board. begin() does this, so it only needs to be
+    /// called directly to pick up replies before then. While they run, update only drains replies
+    bool start_readers();
+    /// stop the background reply readers. returns whether they were running
+    bool stop_readers();
     /// halt the scheduler, cancelling all events and schedulers
     bool halt_scheduler();
+    /// stop stimulating on every board but keep the schedules and events there, eg. for a rest
+    /// break. Unlike disable, resume gets stimulation back without setting anything up again
+    bool pause();
+    /// restart the schedules on every board after pause
+    bool resume();
+    /// return whether the stimulator is paused
+    bool is_paused();
     /// return the name of the stimulator
     std::string get_name();
+    /// return the transport used to talk to the given board (0 or 1)
+    Transport* get_transport(size_t board_num_);
+    /// return the messages, bytes, and device calls of the last update
+    UpdateStats get_update_stats();
+    /// set what to do when the event updates of a board do not fit on its link within one schedule
+    /// period: refuse the events, send them less often, or take turns (default). Set this before
+    /// create_scheduler and add_events, which check the link budget
+    void set_link_policy(LinkPolicy link_policy_);
+    /// return how the worst case traffic of the events on a board (0 or 1) compares to its link
+    LinkBudget get_link_budget(size_t board_num_);
+    /// set how many bytes may still be waiting to go out on a link when its updates are sent. While
+    /// more are waiting, the updates of that board are held back so that the board never acts on
+    /// stale values. 0 never holds updates back
+    void set_max_queued(size_t max_queued_);
+    /// return the time from the last stop (halt, or channels set to zero amplitude) being requested
+    /// to its last byte going out on the wire, taking the slowest board
+    mahi::util::Time get_stop_latency();
+    /// start capturing everything written to and read from the boards to filename_ (see
+    /// CaptureWriter), with board 0 or 1 as the port. The constructors enable the stimulator, so
+    /// pass the file to the constructor instead to capture the setup messages too. Not allowed
+    /// while the I/O threads are running
+    bool start_capture(const std::string& filename_);
+    /// stop capturing and write out what is still buffered. Not allowed while the I/O threads are
+    /// running
+    void stop_capture();
+    /// return the counters of the current (or last) capture
+    CaptureStats get_capture_stats();
+    /// stimulate a channel right away with count_ pulses of the given pulsewidth and amplitude,
+    /// spacing_ apart (eg. a doublet), outside of the schedule. Each pulse is an event command
+    /// sent through the priority lane, so it does not wait for the next schedule period. The
+    /// first pulse is sent before this returns, and the rest are timed and sent by a background
+    /// thread. A new burst can not be fired until the last one has been sent. The pulsewidth and
+    /// amplitude are clamped to the limits of the channel
+    bool fire(Channel channel_, unsigned int pw_, unsigned int amp_, unsigned int count_ = 1,
+              mahi::util::Time spacing_ = mahi::util::Time::Zero);
+    /// return the counters and estimated trigger to wire latency of the pulses sent by fire
+    FireStats get_fire_stats();
+    /// set how long a pulse sent by fire may wait for its reply before it is counted as unanswered
+    /// (100 ms by default)
+    void set_fire_reply_timeout(mahi::util::Time timeout_);
+    /// set a callback for the replies to the pulses sent by fire. Callbacks are called from update
+    void set_on_event_command(ReplyDispatcher::EventCommandCallback on_event_command_);
+    /// set a callback for the error reports sent by the boards (a message they could not act on).
+    /// Every error report is logged and makes the update it arrives in fail, whether or not a
+    /// callback is set. Callbacks are called from update
+    void set_on_error_report(ReplyDispatcher::ErrorReportCallback on_error_report_);
+    /// set a callback for the event errors sent by the boards (an event they could not run). Every
+    /// event error is logged and makes the update it arrives in fail, whether or not a callback is set
+    void set_on_event_error(ReplyDispatcher::EventErrorCallback on_event_error_);
 
     size_t                   num_events;       // number of events the stimulator is handling
     std::vector<int>         amplitudes;       // vector of amplitudes corresponding to channels
@@ -79,39 +194,71 @@ public:
     std::vector<std::string> channel_names;    // returns vector of the names of the channels
 
 private:
-    /// open the comport that the UECU is controlled from
-    bool open_port(HANDLE* hComm, std::string com_port);
-    /// configure the comport that the UECU is controlled from
-    bool configure_port(HANDLE* hComm);
     /// initialize the board by enabling each of the channels given setup parameters
     bool initialize_board();
     /// halt the stimulator and close the comports
     void close_stimulator();
+    /// collects the traffic of the I/O threads and disables the stimulator if any of them failed
+    bool check_io_threads();
+    /// hands every reply that has arrived from the boards to the reply dispatcher. returns false if
+    /// any was invalid or reported an error
+    bool check_replies();
+    /// sends a pulse of fire to channel_ of board_, due at due_ on the fire clock, and keeps track
+    /// of it until its reply arrives. Called from the caller of fire and from the fire worker
+    bool send_pulse(size_t board_, unsigned char channel_, const StimEventCommandFrame& pulse_, mahi::util::Time due_);
+    /// counts the pulses that have waited longer than the reply timeout as unanswered
+    void check_fire_replies();
+    /// runs task_ for every board at the same time (with the board number as its argument) and
+    /// waits for all of them. returns false if the task failed for any board
+    bool for_each_port(const std::function<bool(size_t)>& task_);
     /// read all incoming messages from the stimulator
     // void read_all();
 
 
-    DCB    m_dcbSerialParams = {0};  // serial parameters to handle the serial communication to UECU
-
     mahi::util::Time m_delay_time = mahi::util::milliseconds(100);  // delay time when sending messages
 
-    HANDLE                   m_hComm_1;            // serial handle to the appropriate UECU first set of 4 channels
-    HANDLE                   m_hComm_2;            // serial handle to the appropriate UECU second set of 4 channels
-    std::vector<HANDLE*>     m_hComms;             // vector of pointers to m_hComm_1 and m_hComm_2
     std::string              m_name;               // name of the stimulator
-    std::string              m_com_port_1;         // comport that the 2nd set of 4 channels for the UECU is written to from. should be in format COMX or COMXX.
-    std::string              m_com_port_2;         // comport that the 2nd set of 4 channels for the UECU is written to from. should be in format COMX or COMXX. This defaults to "NONE"
-    std::vector<std::string> m_com_ports;          // vector of {m_com_port_1, m_com_port_2} to iterate over
-    size_t                   m_num_ports = 1;      // total number of comports. This is 1 if m_com_port_2 is "NONE" and 2 if m_com_port_2 is COMX
+    std::vector<std::unique_ptr<Transport>> m_transports;  // transports to each UECU board. The first handles channels 1-4 and the second channels 5-8
+    std::vector<std::unique_ptr<ReplyReader>> m_readers;   // background reply reader for each transport
+    size_t                   m_num_ports = 1;      // total number of ports. This is 1 if com_port_2 is "NONE" and 2 if com_port_2 is COMX
     bool                     m_enabled;            // shows if the stimulator has been enabled
     bool                     m_is_virtual;         // determines whether or not to wait for responses from the stimulator
     std::vector<Channel>     m_channels;           // vector of channels enabled by the stim board
     Scheduler                m_scheduler_1;        // scheduler which handles events
     Scheduler                m_scheduler_2;        // scheduler which handles events
     std::vector<Scheduler*>  m_schedulers;
+    std::vector<std::unique_ptr<PortWorker>> m_workers;  // workers that handle every board but the first in for_each_port
     int                      m_inc_msg_count = 0;  // number of messages the stimulator has received
     std::queue<ReadMessage>  m_inc_messages;       // queue of incoming messages
     std::mutex               m_mtx;                // mutex for handling simultaneous reading/writing
+    UpdateStats              m_update_stats;       // traffic of the last update
+    std::vector<TransportStats> m_io_stats;        // transport counters at the previous update while I/O threaded
+    std::vector<size_t>         m_io_counts;       // event messages sent by each I/O thread at the previous update
+    std::vector<size_t>         m_held_counts;     // updates each scheduler had held back at the previous update
+    Reply                       m_reply;           // scratch reply used while draining the readers
+    ReplyDispatcher             m_dispatcher;      // hands the replies to the handler of their type
+    bool                        m_board_error = false;  // set when a board reports an error, cleared each check_replies
+    ReplyDispatcher::ErrorReportCallback m_on_error_report;  // user callback for error reports, if set
+    ReplyDispatcher::EventErrorCallback  m_on_event_error;   // user callback for event errors, if set
+    ReplyDispatcher::EventCommandCallback m_on_event_command;  // user callback for event command replies, if set
+    /// A pulse sent by fire that is still waiting on its reply
+    struct FirePulse {
+        size_t           board;    // board the pulse was sent to
+        unsigned char    channel;  // channel on the board
+        mahi::util::Time sent;     // when it was sent, on the fire clock
+    };
+
+    size_t                      m_reply_board = 0;  // board the reply being dispatched came from
+    FireStats                   m_fire_stats;      // pulses sent by fire
+    std::vector<FirePulse>      m_fire_pending;    // pulses sent by fire still waiting on their reply, oldest first
+    std::mutex                  m_fire_mtx;        // guards m_fire_stats and m_fire_pending, which the fire worker updates too
+    mahi::util::Clock           m_fire_clock;      // time base for the pulses sent by fire
+    mahi::util::Time            m_fire_reply_timeout = mahi::util::milliseconds(100);  // how long a pulse may wait on its reply
+    std::atomic<bool>           m_fire_cancel;     // tells the fire worker to drop the rest of its burst
+    std::unique_ptr<PortWorker> m_fire_worker;     // sends the pulses of a burst after the first, created with the first burst
+    std::vector<TransportStats> m_stats_before;    // transport counters at the start of the current update
+    std::vector<size_t>         m_held_before;     // held back counts at the start of the current update
+    CaptureWriter               m_capture;         // capture of the traffic to and from the boards, if started
 };
 }  // namespace fes
 }  // namespace mahi
\ No newline at end of file
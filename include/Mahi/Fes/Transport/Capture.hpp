@@ -0,0 +1,128 @@
+// MIT License
+//
+// Copyright (c) 2020 Mechatronics and Haptic Interfaces Lab - Rice University
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// Author(s): Nathan Dunkelberger (nbd2@rice.edu)
+
+#pragma once
+
+#include <Mahi/Fes/Transport/Transport.hpp>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// A capture file is an 8 byte magic string, then one record per chunk of bytes that crossed a
+// link: timestamp (8 bytes, ns on a monotonic clock), port (1 byte), direction (1 byte, 0 for
+// written and 1 for read), size (2 bytes), then the bytes themselves. All numbers are little
+// endian, and records are packed one after the other.
+#define CAPTURE_MAGIC              "FESCAP01"
+#define CAPTURE_MAGIC_SIZE         8
+#define CAPTURE_RECORD_HEADER_SIZE 12
+#define CAPTURE_BUFFER_SIZE        65536  // bytes in each of the two write buffers
+
+namespace mahi {
+namespace fes {
+
+/// Counters kept by a CaptureWriter
+struct CaptureStats {
+    std::uint64_t records = 0;  // records written
+    std::uint64_t bytes   = 0;  // captured bytes written (not counting record headers)
+    std::uint64_t dropped = 0;  // records dropped because both buffers were full
+};
+
+/// Writes everything that crosses one or more transports to a capture file. Records are
+/// copied into one of two preallocated buffers while a background thread writes the other one
+/// to disk, so the thread doing the I/O never waits on the disk. If the disk falls so far
+/// behind that both buffers are full, records are dropped and counted rather than waited on.
+class CaptureWriter {
+public:
+    /// CaptureWriter constructor
+    CaptureWriter(size_t buffer_size_ = CAPTURE_BUFFER_SIZE);
+    /// CaptureWriter destructor. Writes out anything still buffered
+    ~CaptureWriter();
+    /// creates the capture file and starts the writer thread
+    bool open(const std::string& filename_);
+    /// writes out anything still buffered and closes the capture file
+    void close();
+    /// returns whether a capture file is open
+    bool is_open();
+    /// captures everything written to and read from transport_ as port port_ (see
+    /// Transport::set_tap). The writer must outlive the tap
+    void attach(Transport& transport_, unsigned char port_);
+    /// adds a record of size_ bytes of data_ that crossed port port_, read if received_
+    void record(unsigned char port_, bool received_, const unsigned char* data_, size_t size_);
+    /// returns a snapshot of the counters
+    CaptureStats get_stats();
+
+private:
+    /// loop run by the writer thread
+    void write_loop();
+    /// hands the buffer being filled to the writer thread. m_mtx must be held
+    bool swap_buffers();
+
+    std::FILE*                 m_file;        // capture file
+    std::vector<unsigned char> m_buffers[2];  // preallocated record buffers
+    size_t                     m_fill[2];     // bytes used in each buffer
+    int                        m_active;      // buffer records are added to
+    bool                       m_pending;     // whether the other buffer is waiting to be written
+    bool                       m_running;     // whether the writer thread should keep running
+    CaptureStats               m_stats;       // counters
+    std::mutex                 m_mtx;         // guards everything above except the file
+    std::condition_variable    m_cv;          // wakes the writer thread
+    std::thread                m_thread;      // writer thread
+};
+
+/// One record of a capture file. data points into the mapped file and is only valid while
+/// the reader stays open
+struct CaptureRecord {
+    std::uint64_t        time_ns  = 0;        // when the bytes crossed the link (ns)
+    unsigned char        port     = 0;        // port they crossed
+    bool                 received = false;    // whether they were read (true) or written (false)
+    const unsigned char* data     = nullptr;  // the bytes
+    size_t               size     = 0;        // number of bytes
+};
+
+/// Reads a capture file through a memory mapping, so that even long captures can be walked
+/// through without copying them into memory first
+class CaptureReader {
+public:
+    /// CaptureReader constructor
+    CaptureReader();
+    /// CaptureReader destructor
+    ~CaptureReader();
+    /// maps the capture file and checks its magic string
+    bool open(const std::string& filename_);
+    /// unmaps the capture file
+    void close();
+    /// reads the next record into record_. returns false at the end of the file, or if the
+    /// rest of the file is cut off
+    bool next(CaptureRecord& record_);
+    /// goes back to the first record
+    void rewind();
+    /// returns the size of the capture file in bytes
+    size_t get_size();
+
+private:
+    const unsigned char* m_data;     // mapped file
+    size_t               m_size;     // size of the mapped file
+    size_t               m_offset;   // offset of the next record
+    void*                m_file;     // file handle (Windows only)
+    void*                m_mapping;  // file mapping handle (Windows only)
+};
+
+}  // namespace fes
+}  // namespace mahi
@@ -0,0 +1,73 @@
+// MIT License
+//
+// Copyright (c) 2020 Mechatronics and Haptic Interfaces Lab - Rice University
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// Author(s): Nathan Dunkelberger (nbd2@rice.edu)
+
+#pragma once
+
+#include <Mahi/Fes/Transport/Transport.hpp>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+
+namespace mahi {
+namespace fes {
+
+/// In-process transport. Loopback transports are always created as a connected pair, where
+/// anything written to one end can be read from the other. This lets the stimulator be run
+/// against a board-side stand-in in the same process, without any hardware or OS devices. There
+/// is no wire, so a loopback has no transmit queue of its own (get_output_queue_depth returns 0):
+/// written bytes are handed to the other end right away, whether or not anything reads them.
+class LoopbackTransport : public Transport {
+public:
+    /// one direction of the link between the two ends of a pair
+    struct Pipe {
+        std::mutex                mtx;    // guards bytes
+        std::condition_variable   cv;     // notified when bytes are added
+        std::deque<unsigned char> bytes;  // bytes written but not yet read
+    };
+
+    /// creates two connected loopback transports (eg. host side and board side)
+    static std::pair<std::unique_ptr<LoopbackTransport>, std::unique_ptr<LoopbackTransport>>
+    make_pair(const std::string& name_, unsigned int baud_rate_ = 9600);
+
+    /// LoopbackTransport constructor. Use make_pair to get a connected pair
+    LoopbackTransport(const std::string& name_, unsigned int baud_rate_, std::shared_ptr<Pipe> tx_,
+                      std::shared_ptr<Pipe> rx_);
+    /// LoopbackTransport destructor
+    ~LoopbackTransport();
+    /// opens this end of the pair
+    bool open() override;
+    /// closes this end of the pair
+    void close() override;
+    /// returns whether this end of the pair is open
+    bool is_open() override;
+    /// discards any bytes that have been received but not read
+    void purge() override;
+
+protected:
+    bool   write_bytes(const unsigned char* data_, size_t size_) override;
+    size_t read_bytes(unsigned char* data_, size_t size_, mahi::util::Time timeout_) override;
+
+private:
+    std::shared_ptr<Pipe> m_tx;    // bytes written by this end
+    std::shared_ptr<Pipe> m_rx;    // bytes written by the other end
+    bool                  m_open;  // whether this end is open
+};
+
+}  // namespace fes
+}  // namespace mahi
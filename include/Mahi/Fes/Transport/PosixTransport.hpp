@@ -0,0 +1,66 @@
+// MIT License
+//
+// Copyright (c) 2020 Mechatronics and Haptic Interfaces Lab - Rice University
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// Author(s): Nathan Dunkelberger (nbd2@rice.edu)
+
+#pragma once
+
+#include <Mahi/Fes/Transport/Transport.hpp>
+#include <string>
+
+namespace mahi {
+namespace fes {
+
+/// Serial transport for a POSIX tty device (eg. /dev/ttyUSB0). The device is opened
+/// non-blocking and set to raw 8N1. Rather than relying on driver read timeouts, reads and
+/// writes wait for readiness with epoll, and timeouts are armed on a timerfd so that a read
+/// returns as soon as a byte shows up and never stalls longer than the requested timeout.
+class PosixTransport : public Transport {
+public:
+    /// PosixTransport constructor
+    PosixTransport(const std::string& device_, unsigned int baud_rate_ = 9600);
+    /// PosixTransport destructor
+    ~PosixTransport();
+    /// opens the device non-blocking, configures it for the UECU and sets up the epoll waits
+    bool open() override;
+    /// closes the device and the epoll/timer descriptors
+    void close() override;
+    /// returns whether the device is open
+    bool is_open() override;
+    /// flushes the transmit and receive buffers of the device
+    void purge() override;
+    /// returns the number of bytes still in the transmit queue of the device driver (TIOCOUTQ)
+    size_t get_output_queue_depth() override;
+
+protected:
+    bool   write_bytes(const unsigned char* data_, size_t size_) override;
+    size_t read_bytes(unsigned char* data_, size_t size_, mahi::util::Time timeout_) override;
+
+protected:
+    /// sets the device to raw 8N1 at the configured baud rate
+    bool configure_port();
+    /// creates an epoll instance watching the device for events_ and a timerfd for timeouts
+    bool create_waiter(int& epoll_fd_, int& timer_fd_, unsigned int events_);
+    /// waits until the device is ready on epoll_fd_ or timeout_ elapses. returns true if ready
+    bool wait_ready(int epoll_fd_, int timer_fd_, mahi::util::Time timeout_);
+
+    int m_fd;        // file descriptor of the open device
+    int m_rx_epoll;  // epoll instance waiting for the device to become readable
+    int m_rx_timer;  // timerfd bounding read waits
+    int m_tx_epoll;  // epoll instance waiting for the device to become writable
+    int m_tx_timer;  // timerfd bounding write waits
+};
+
+}  // namespace fes
+}  // namespace mahi
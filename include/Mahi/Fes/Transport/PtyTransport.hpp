@@ -0,0 +1,48 @@
+// MIT License
+//
+// Copyright (c) 2020 Mechatronics and Haptic Interfaces Lab - Rice University
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// Author(s): Nathan Dunkelberger (nbd2@rice.edu)
+
+#pragma once
+
+#include <Mahi/Fes/Transport/PosixTransport.hpp>
+#include <string>
+
+namespace mahi {
+namespace fes {
+
+/// Pseudo terminal transport. Opening it creates a new pty pair, and this transport is the
+/// master end. Anything that opens the slave end (see get_slave_name, eg. /dev/pts/3) as a
+/// serial port talks to whatever is on this end, so it can stand in for the board side of a
+/// real serial link (eg. for a UecuEmulator) on a machine without any stimulator hardware.
+class PtyTransport : public PosixTransport {
+public:
+    /// PtyTransport constructor
+    PtyTransport(unsigned int baud_rate_ = 9600);
+    /// PtyTransport destructor
+    ~PtyTransport();
+    /// creates the pty pair and sets it to raw 8N1
+    bool open() override;
+    /// closes both ends of the pty pair
+    void close() override;
+    /// returns the path of the slave end, which the other side should open as its serial port
+    std::string get_slave_name();
+
+private:
+    int         m_slave_fd;    // slave end, held open so the master never sees a hang up
+    std::string m_slave_name;  // path of the slave end
+};
+
+}  // namespace fes
+}  // namespace mahi
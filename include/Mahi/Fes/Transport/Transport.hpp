@@ -0,0 +1,151 @@
+// MIT License
+//
+// Copyright (c) 2020 Mechatronics and Haptic Interfaces Lab - Rice University
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// Author(s): Nathan Dunkelberger (nbd2@rice.edu)
+
+#pragma once
+
+#include <Mahi/Util.hpp>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+
+#define TX_QUEUE_SIZE  4096  // bytes of routine writes a transport can hold back while the link is busy
+#define TX_WINDOW_SIZE 16    // routine bytes allowed in the device's transmit queue by default
+
+namespace mahi {
+namespace fes {
+
+/// Running counters for everything that has crossed a transport
+struct TransportStats {
+    std::uint64_t bytes_written   = 0;  // total number of bytes handed to the link
+    std::uint64_t bytes_read      = 0;  // total number of bytes received from the link
+    std::uint64_t write_calls     = 0;  // number of write calls issued to the underlying device
+    std::uint64_t read_calls      = 0;  // number of read calls issued to the underlying device
+    std::uint64_t priority_writes = 0;  // number of writes that went through the priority lane
+};
+
+/// A transport is the byte link between the host and a single UECU board. Everything that is
+/// sent to or received from a board goes through one of these, so the protocol classes
+/// (Channel, Event, Scheduler, Stimulator) never touch the operating system directly. Derived
+/// classes implement the device specific open/close/read/write, and the base class keeps
+/// track of how much traffic went over the link.
+///
+/// Writes go out in one of two lanes, making up a two level transmit queue. Routine writes (event
+/// updates, etc.) are only handed to the device while its transmit queue holds no more than the
+/// transmit window. The rest wait in the transport, in order, and are handed over as the device
+/// catches up (on the next write or read). Priority writes (halts, zero amplitudes, deletes) are
+/// handed to the device right away, ahead of every routine write still waiting in the transport,
+/// so a stop only waits behind the routine bytes the device already had. Each write is kept
+/// whole, so a priority write never lands in the middle of a routine message. Transports that
+/// cannot tell how full the device is (get_output_queue_depth returns 0) hand everything over
+/// right away.
+class Transport {
+public:
+    /// called with every chunk of bytes that crosses the link. received_ is false for bytes that
+    /// were written and true for bytes that were read
+    typedef std::function<void(bool received_, const unsigned char* data_, size_t size_)> Tap;
+
+    /// Transport constructor
+    Transport(const std::string& name_, unsigned int baud_rate_);
+    /// Transport destructor
+    virtual ~Transport();
+    /// opens and configures the underlying device
+    virtual bool open() = 0;
+    /// closes the underlying device
+    virtual void close() = 0;
+    /// returns whether the underlying device is currently open
+    virtual bool is_open() = 0;
+    /// discards anything waiting in the transmit and receive buffers
+    virtual void purge();
+    /// returns the number of bytes handed to the device but not yet sent out on the wire.
+    /// Transports that cannot tell return 0
+    virtual size_t get_output_queue_depth();
+    /// returns the number of bytes written but not yet sent out on the wire, counting both the
+    /// routine writes waiting in the transport and the device's transmit queue
+    size_t get_pending_bytes();
+    /// writes all size_ bytes of data_ to the link through the routine lane. If the device is
+    /// busy, they wait in the transport behind earlier routine writes. returns false if they could
+    /// not all be written or queued
+    bool write(const unsigned char* data_, size_t size_);
+    /// writes all size_ bytes of data_ to the device right away, ahead of any routine writes
+    /// waiting in the transport. returns false if they could not all be written
+    bool write_priority(const unsigned char* data_, size_t size_);
+    /// drops the routine writes still waiting in the transport, so that they never reach the
+    /// device. What the device already has is left alone. returns the number of bytes dropped
+    size_t discard_queued();
+    /// sets how many routine bytes may be in the device's transmit queue before further routine
+    /// writes wait in the transport (TX_WINDOW_SIZE by default). This bounds how many routine
+    /// bytes a priority write can end up behind. 0 hands routine writes over right away
+    void set_transmit_window(size_t window_);
+    /// reads up to size_ bytes into data_, waiting at most timeout_ for the first byte to arrive.
+    /// returns the number of bytes read, which is 0 if nothing arrived
+    size_t read(unsigned char* data_, size_t size_, mahi::util::Time timeout_);
+    /// reads exactly size_ bytes into data_ unless nothing arrives within timeout_. Once the first
+    /// byte has arrived, the rest is given enough time to come over the wire. returns bytes read
+    size_t read_exact(unsigned char* data_, size_t size_, mahi::util::Time timeout_);
+    /// returns the name of the transport (usually the port name)
+    std::string get_name();
+    /// returns the baud rate the link is configured for
+    unsigned int get_baud_rate();
+    /// returns the time it takes to send a single byte (8N1, so 10 bits) at the configured baud rate
+    mahi::util::Time get_byte_time();
+    /// returns a snapshot of the traffic counters for this transport
+    TransportStats get_stats();
+    /// sets a tap that sees everything written to and read from the link (eg. to capture or
+    /// simulate the traffic). Writes are seen in the order they went out. Set it before the
+    /// transport is used from other threads, and pass nullptr to remove it
+    void set_tap(Tap tap_);
+
+protected:
+    /// device specific write of size_ bytes. must write all bytes or return false
+    virtual bool write_bytes(const unsigned char* data_, size_t size_) = 0;
+    /// device specific read of up to size_ bytes. returns as soon as any data is there, waiting at
+    /// most timeout_ for the first byte
+    virtual size_t read_bytes(unsigned char* data_, size_t size_, mahi::util::Time timeout_) = 0;
+
+    std::string  m_name;       // name of the transport
+    unsigned int m_baud_rate;  // baud rate of the link in bits per second
+
+private:
+    std::atomic<std::uint64_t> m_bytes_written;     // running count of bytes written
+    std::atomic<std::uint64_t> m_bytes_read;        // running count of bytes read
+    std::atomic<std::uint64_t> m_write_calls;       // running count of device write calls
+    std::atomic<std::uint64_t> m_read_calls;        // running count of device read calls
+    std::atomic<std::uint64_t> m_priority_writes;   // running count of priority writes
+    std::mutex                 m_write_mtx;         // lets one write at a time onto the link
+    Tap                        m_tap;               // sees all traffic, if set
+
+    /// hands size_ bytes to the device and counts them. Call with m_write_mtx held
+    bool send(const unsigned char* data_, size_t size_);
+    /// returns whether size_ more routine bytes may be handed to the device now
+    bool fits_window(size_t size_);
+    /// hands the routine writes waiting in the transport to the device, oldest first, for as long
+    /// as they fit in the transmit window. Call with m_write_mtx held. returns false if any failed
+    bool pump();
+
+    unsigned char       m_tx_queue[TX_QUEUE_SIZE];  // routine writes waiting for the device, each after its 2 byte size
+    size_t              m_tx_size;                  // number of bytes used in m_tx_queue
+    std::atomic<size_t> m_tx_queued;                // routine bytes waiting in m_tx_queue, sizes not counted
+    size_t              m_tx_window;                // routine bytes allowed in the device's transmit queue
+};
+
+/// opens the native serial transport for this platform (Win32 COM port or POSIX tty device)
+std::unique_ptr<Transport> make_serial_transport(const std::string& port_, unsigned int baud_rate_ = 9600);
+
+}  // namespace fes
+}  // namespace mahi
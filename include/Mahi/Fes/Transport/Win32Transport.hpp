@@ -0,0 +1,62 @@
+// MIT License
+//
+// Copyright (c) 2020 Mechatronics and Haptic Interfaces Lab - Rice University
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// Author(s): Nathan Dunkelberger (nbd2@rice.edu)
+
+#pragma once
+
+#include <Windows.h>
+
+#include <Mahi/Fes/Transport/Transport.hpp>
+#include <string>
+
+namespace mahi {
+namespace fes {
+
+/// Serial transport for a Windows COM port. The port name should be in the format COMX or COMXX.
+/// The port is opened for overlapped I/O, since Windows runs the reads and writes of a synchronous
+/// handle one after the other, and a reply reader waiting on a read would hold up every write.
+class Win32Transport : public Transport {
+public:
+    /// Win32Transport constructor
+    Win32Transport(const std::string& com_port_, unsigned int baud_rate_ = CBR_9600);
+    /// Win32Transport destructor
+    ~Win32Transport();
+    /// opens the comport with read/write permissions and configures it for the UECU
+    bool open() override;
+    /// closes the comport
+    void close() override;
+    /// returns whether the comport is open
+    bool is_open() override;
+    /// aborts and clears the transmit and receive buffers of the comport
+    void purge() override;
+    /// returns the number of bytes still in the transmit queue of the comport
+    size_t get_output_queue_depth() override;
+
+protected:
+    bool   write_bytes(const unsigned char* data_, size_t size_) override;
+    size_t read_bytes(unsigned char* data_, size_t size_, mahi::util::Time timeout_) override;
+
+private:
+    /// configure the comport that the UECU is controlled from
+    bool configure_port();
+
+    DCB    m_dcbSerialParams = {0};  // serial parameters to handle the serial communication to UECU
+    HANDLE m_hComm;                  // serial handle to the UECU, opened for overlapped I/O
+    HANDLE m_read_event;             // signaled when the pending read completes
+    HANDLE m_write_event;            // signaled when the pending write completes
+};
+
+}  // namespace fes
+}  // namespace mahi
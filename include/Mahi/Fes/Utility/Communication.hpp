@@ -1,18 +1,22 @@
 #pragma once
 
-#include <Windows.h>
-
 #include <Mahi/Util.hpp>
 #include <Mahi/Fes/Core/ReadMessage.hpp>
+#include <Mahi/Fes/Transport/Transport.hpp>
+#include <Mahi/Fes/Utility/ReplyParser.hpp>
+#include <memory>
 #include <queue>
 
 namespace mahi {
 namespace fes {
 /// continues to read messages while messages are available and returns all read messages
-std::vector<ReadMessage> get_all_messages(std::vector<HANDLE*> hComms, size_t num_ports);
+std::vector<ReadMessage> get_all_messages(const std::vector<std::unique_ptr<Transport>>& transports);
 /// currently prints out all of the new incoming messages in a readable format to the commmand line
-void process_inc_messages(HANDLE hComm, std::queue<ReadMessage> &inc_messages);
-/// reads a single message from the serial handle. 
-std::vector<unsigned char> read_message(HANDLE hComm, bool should_wait, mahi::util::Time timeout = mahi::util::seconds(1));
+void process_inc_messages(std::queue<ReadMessage> &inc_messages);
+/// reads a single message from the transport. 
+std::vector<unsigned char> read_message(Transport& transport, bool should_wait, mahi::util::Time timeout = mahi::util::seconds(1));
+/// reads a single message from the transport into buffer, and returns a view of it there. The
+/// view is empty if no message was read, and is only good until buffer is used again
+ReadMessageView read_message(Transport& transport, Reply& buffer, bool should_wait, mahi::util::Time timeout = mahi::util::seconds(1));
 }  // namespace fes
 }  // namespace mahi
\ No newline at end of file
@@ -0,0 +1,60 @@
+// MIT License
+//
+// Copyright (c) 2020 Mechatronics and Haptic Interfaces Lab - Rice University
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// Author(s): Nathan Dunkelberger (nbd2@rice.edu)
+
+#pragma once
+
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+namespace mahi {
+namespace fes {
+
+/// A thread that runs one task at a time on request. The stimulator keeps one per extra board
+/// so that the work for each board (writing updates, sending sync messages, etc.) happens at
+/// the same time instead of one board after the other. The thread is started once and reused,
+/// so submitting a task only costs a wake-up.
+class PortWorker {
+public:
+    /// PortWorker constructor. Starts the worker thread
+    PortWorker();
+    /// PortWorker destructor. Stops the worker thread once the current task is done
+    ~PortWorker();
+    /// hands task_ to the worker thread. If the previous task is still running, this waits for it
+    /// to finish first, and its result is dropped unless it was waited on
+    void submit(std::function<bool()> task_);
+    /// waits for the submitted task to finish and returns its result
+    bool wait();
+    /// returns whether the submitted task has finished, without waiting for it
+    bool is_done();
+
+private:
+    /// loop run by the worker thread
+    void work_loop();
+
+    std::mutex              m_mtx;       // guards everything below
+    std::condition_variable m_cv;        // signals a new task, a finished task, or stopping
+    std::function<bool()>   m_task;      // task to run
+    bool                    m_has_task;  // whether m_task is waiting to be run
+    bool                    m_done;      // whether the last submitted task has finished
+    bool                    m_result;    // result of the last finished task
+    bool                    m_stop;      // whether the worker thread should exit
+    std::thread             m_thread;    // worker thread
+};
+
+}  // namespace fes
+}  // namespace mahi
@@ -0,0 +1,120 @@
+// MIT License
+//
+// Copyright (c) 2020 Mechatronics and Haptic Interfaces Lab - Rice University
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// Author(s): Nathan Dunkelberger (nbd2@rice.edu)
+
+
+#pragma once
+
+#include <Mahi/Fes/Core/ReadMessage.hpp>
+#include <Mahi/Fes/Utility/ReplyParser.hpp>
+#include <cstdint>
+#include <functional>
+
+namespace mahi {
+namespace fes {
+
+/// ERROR_REPORT_MSG: the board could not act on a message
+struct ErrorReport {
+    unsigned char error;     // error code reported by the board
+    unsigned char msg_type;  // type of the message that failed
+};
+
+/// EVENT_ERROR_MSG: an event could not be run as set up (eg. its parameters are over the limits)
+struct EventErrorReport {
+    unsigned char error;       // error code reported by the board
+    unsigned char event_id;    // id of the event that failed
+    unsigned char event_type;  // type of the event that failed
+    unsigned char channel;     // board channel of the event that failed
+};
+
+/// CREATE_SCHEDULE_REPLY_MSG: a schedule was created
+struct ScheduleCreatedReply {
+    unsigned char schedule_id;  // id the board gave the new schedule
+};
+
+/// CREATE_EVENT_REPLY_MSG: an event was created
+struct EventCreatedReply {
+    unsigned char event_id;     // id the board gave the new event
+    unsigned char schedule_id;  // schedule the event was added to
+    unsigned char event_type;   // type of the new event
+    unsigned char channel;      // board channel of the new event
+};
+
+/// EVENT_COMMAND_REPLY_MSG: an immediate event was run
+struct EventCommandReply {
+    unsigned char event_id;    // id of the event (0x00, an immediate event has none of its own)
+    unsigned char event_type;  // type of the event that was run
+    unsigned char channel;     // board channel the event was run on
+};
+
+/// each decode_reply fills the struct from reply_ and returns whether reply_ is of that type and
+/// holds enough data for it. The crc is not checked
+bool decode_reply(const ReadMessageView& reply_, ErrorReport& decoded_);
+bool decode_reply(const ReadMessageView& reply_, EventErrorReport& decoded_);
+bool decode_reply(const ReadMessageView& reply_, ScheduleCreatedReply& decoded_);
+bool decode_reply(const ReadMessageView& reply_, EventCreatedReply& decoded_);
+bool decode_reply(const ReadMessageView& reply_, EventCommandReply& decoded_);
+
+/// Counters kept by a ReplyDispatcher
+struct ReplyDispatcherStats {
+    std::uint64_t dispatched = 0;  // replies decoded and handed to their handler
+    std::uint64_t crc_errors = 0;  // replies that failed the crc check
+    std::uint64_t unknown    = 0;  // replies of a type the UECU does not send
+    std::uint64_t malformed  = 0;  // replies too short for their type
+};
+
+/// Hands every reply from a board to the callback registered for its type, already decoded. The
+/// dispatcher keeps a 256 entry table from the type byte to the handler of that type, so a reply
+/// costs its crc check and one table lookup, and nothing is allocated. Replies of a type the UECU
+/// sends but without a callback are still decoded (and so checked), then dropped. Callbacks are
+/// called on the thread that calls dispatch.
+class ReplyDispatcher {
+public:
+    typedef std::function<void(const ErrorReport&)>          ErrorReportCallback;
+    typedef std::function<void(const EventErrorReport&)>     EventErrorCallback;
+    typedef std::function<void(const ScheduleCreatedReply&)> ScheduleCreatedCallback;
+    typedef std::function<void(const EventCreatedReply&)>    EventCreatedCallback;
+    typedef std::function<void(const EventCommandReply&)>    EventCommandCallback;
+
+    /// ReplyDispatcher constructor
+    ReplyDispatcher();
+    /// each on_ function sets the callback for one type of reply. Pass nullptr to remove it
+    void on_error_report(ErrorReportCallback callback_);
+    void on_event_error(EventErrorCallback callback_);
+    void on_schedule_created(ScheduleCreatedCallback callback_);
+    void on_event_created(EventCreatedCallback callback_);
+    void on_event_command(EventCommandCallback callback_);
+    /// checks reply_ and hands it to the callback for its type. returns false if it failed the
+    /// crc check, is not of a type the UECU sends, or is too short for its type
+    bool dispatch(const ReadMessageView& reply_);
+    /// dispatches a reply put together by a ReplyParser
+    bool dispatch(const Reply& reply_);
+    /// returns the dispatcher counters
+    ReplyDispatcherStats get_stats();
+
+private:
+    /// decodes a reply and calls the callback of its type. returns false if it could not be decoded
+    typedef std::function<bool(const ReadMessageView&)> Handler;
+
+    /// returns the handler that decodes replies into Decoded and calls callback_ (if set)
+    template <typename Decoded>
+    static Handler make_handler(std::function<void(const Decoded&)> callback_);
+
+    Handler              m_handlers[256];  // handler for each type byte, empty for types the UECU does not send
+    ReplyDispatcherStats m_stats;          // dispatcher counters
+};
+
+}  // namespace fes
+}  // namespace mahi
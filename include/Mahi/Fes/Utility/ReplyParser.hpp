@@ -0,0 +1,102 @@
+// MIT License
+//
+// Copyright (c) 2020 Mechatronics and Haptic Interfaces Lab - Rice University
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// Author(s): Nathan Dunkelberger (nbd2@rice.edu)
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+#define REPLY_HEADER_SIZE 8    // amulet command/address/length and the UECU dest/src/type/length
+#define REPLY_CRC_SIZE    2    // crc at the end of every reply
+#define MAX_REPLY_SIZE    265  // header, the most data a one byte length can describe, and crc
+
+namespace mahi {
+namespace fes {
+
+/// A complete reply from the UECU, stored inline so that passing it around never allocates.
+/// See ReadMessage for the layout of the bytes
+struct Reply {
+    unsigned char bytes[MAX_REPLY_SIZE];  // the whole message, including header and crc
+    size_t        size  = 0;              // number of bytes used in bytes
+    bool          valid = false;          // whether the type is one the UECU sends (the crc always matched)
+
+    /// returns the message type of the reply
+    unsigned char get_type() const { return bytes[6]; }
+    /// returns the whole message as a vector (eg. for print_message or ReadMessage)
+    std::vector<unsigned char> get_message() const { return std::vector<unsigned char>(bytes, bytes + size); }
+};
+
+/// Counters kept by a ReplyParser
+struct ReplyParserStats {
+    std::uint64_t bytes      = 0;  // bytes fed to the parser
+    std::uint64_t replies    = 0;  // replies that passed the crc check
+    std::uint64_t crc_errors = 0;  // candidate replies that failed the crc check
+    std::uint64_t discarded  = 0;  // bytes that turned out not to belong to any reply
+};
+
+/// Byte-at-a-time parser for UECU replies. Bytes can be fed in pieces of any size, so a
+/// reply split over several reads is put back together. The parser looks for the 0x80 0x04
+/// address pair that every reply carries at bytes 4 and 5 of its header, then takes the type
+/// and length, then the data and crc. If the crc does not match, the candidate was either
+/// corrupted or never was a reply, so everything after its first byte is looked through again
+/// for the next address pair. The crc is worked out as the bytes arrive, so a complete reply
+/// only needs comparing. No memory is allocated while parsing.
+class ReplyParser {
+public:
+    /// called with every reply that passes the crc check. The reply is only valid during the call
+    typedef std::function<void(const Reply&)> Callback;
+
+    /// ReplyParser constructor
+    ReplyParser(Callback on_reply_);
+    /// feeds size_ bytes of the incoming stream to the parser
+    void feed(const unsigned char* data_, size_t size_);
+    /// throws away any partially received reply
+    void reset();
+    /// returns the fewest bytes that must still arrive before a reply can be completed. Reading no
+    /// more than this never takes anything past the end of the next reply
+    size_t get_bytes_needed() const;
+    /// returns the parser counters
+    ReplyParserStats get_stats();
+
+private:
+    /// parser states, in the order a reply arrives
+    enum State {
+        Seek,    // looking for the address pair, keeping the last bytes as the start of the header
+        Type,    // next byte is the message type
+        Length,  // next byte is the data length
+        Body     // collecting the data and crc
+    };
+
+    /// advances the state machine by one byte
+    void step(unsigned char byte_);
+    /// checks the completed candidate and either hands it out or queues it to be looked through
+    void finish();
+
+    Callback         m_on_reply;                      // where completed replies go
+    State            m_state;                         // current parser state
+    Reply            m_reply;                         // reply being put together
+    size_t           m_expected;                      // total size of the reply being put together
+    unsigned int     m_crc;                           // crc of the bytes of the reply so far
+    unsigned char    m_rescan[MAX_REPLY_SIZE];        // bytes waiting to be looked through again
+    size_t           m_rescan_pos;                    // next byte of m_rescan to look through
+    size_t           m_rescan_size;                   // number of bytes used in m_rescan
+    ReplyParserStats m_stats;                         // parser counters
+};
+
+}  // namespace fes
+}  // namespace mahi
@@ -0,0 +1,83 @@
+// MIT License
+//
+// Copyright (c) 2020 Mechatronics and Haptic Interfaces Lab - Rice University
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// Author(s): Nathan Dunkelberger (nbd2@rice.edu)
+
+#pragma once
+
+#include <Mahi/Fes/Transport/Transport.hpp>
+#include <Mahi/Fes/Utility/ReplyParser.hpp>
+#include <Mahi/Fes/Utility/SpscQueue.hpp>
+#include <atomic>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+#define RX_BUFFER_SIZE   256  // bytes taken from the transport per read
+#define REPLY_QUEUE_SIZE 64   // replies that can be waiting before new ones are dropped
+
+namespace mahi {
+namespace fes {
+
+/// Counters kept by a ReplyReader
+struct ReplyReaderStats {
+    std::uint64_t replies    = 0;  // complete replies parsed
+    std::uint64_t crc_errors = 0;  // candidate replies that failed the crc check
+    std::uint64_t dropped    = 0;  // replies thrown away because the queue was full
+    std::uint64_t discarded  = 0;  // bytes that did not belong to any reply
+};
+
+/// Reads replies from one board in the background. The reader thread pulls whatever the
+/// transport has into a fixed receive buffer, feeds it to a ReplyParser, and pushes every
+/// reply the parser completes into a bounded single-producer/single-consumer queue. The
+/// consumer (Stimulator::update) then only drains the queue and never waits on the device.
+/// Only one thread may pop replies, and nothing else may read from the transport while the
+/// reader is running.
+class ReplyReader {
+public:
+    /// ReplyReader constructor
+    ReplyReader(Transport& transport_);
+    /// ReplyReader destructor
+    ~ReplyReader();
+    /// starts the reader thread
+    bool start();
+    /// stops the reader thread. Anything still waiting in the queue can be popped afterwards
+    void stop();
+    /// returns whether the reader thread is running
+    bool is_running();
+    /// pops the oldest reply into reply_. returns false if there is none
+    bool pop(Reply& reply_);
+    /// returns a snapshot of the reader counters
+    ReplyReaderStats get_stats();
+
+private:
+    /// loop run by the reader thread
+    void read_loop();
+    /// queues a reply completed by the parser
+    void on_reply(const Reply& reply_);
+
+    Transport&                          m_transport;                  // transport to read replies from
+    unsigned char                       m_rx_buffer[RX_BUFFER_SIZE];  // bytes received by the last read
+    ReplyParser                         m_parser;                     // puts replies together from the received bytes
+    SpscQueue<Reply, REPLY_QUEUE_SIZE>  m_replies;                    // parsed replies waiting to be popped
+    std::thread                         m_thread;                     // reader thread
+    std::atomic<bool>                   m_running;                    // whether the reader thread should keep running
+    std::atomic<std::uint64_t>          m_reply_count;                // running count of parsed replies
+    std::atomic<std::uint64_t>          m_crc_errors;                 // running count of crc failures
+    std::atomic<std::uint64_t>          m_dropped;                    // running count of dropped replies
+    std::atomic<std::uint64_t>          m_discarded;                  // running count of discarded bytes
+};
+
+}  // namespace fes
+}  // namespace mahi
@@ -0,0 +1,100 @@
+// MIT License
+//
+// Copyright (c) 2020 Mechatronics and Haptic Interfaces Lab - Rice University
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// Author(s): Nathan Dunkelberger (nbd2@rice.edu)
+
+#pragma once
+
+#include <Mahi/Fes/Transport/Transport.hpp>
+#include <Mahi/Fes/Utility/ReplyParser.hpp>
+#include <Mahi/Util.hpp>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#define REPLAY_MAX_DIFFS 32  // differences kept in a ReplayResult (all of them are counted)
+
+namespace mahi {
+namespace fes {
+
+/// A reply that came back differently than it was recorded. expected is empty for replies that
+/// were not recorded, and actual is empty for recorded replies that never came back
+struct ReplayDiff {
+    size_t                     index;     // position of the reply in the session
+    std::vector<unsigned char> expected;  // recorded reply
+    std::vector<unsigned char> actual;    // reply received during the replay
+};
+
+/// Outcome of replaying a session
+struct ReplayResult {
+    size_t                  writes            = 0;  // recorded writes sent
+    std::uint64_t           bytes             = 0;  // bytes sent
+    size_t                  expected_replies  = 0;  // replies in the recording
+    size_t                  received_replies  = 0;  // replies received during the replay
+    size_t                  matched           = 0;  // replies identical to the recorded ones
+    size_t                  mismatched        = 0;  // replies that differed, were missing, or were extra
+    mahi::util::Time        recorded_duration;      // time from the first to the last recorded write
+    mahi::util::Time        replay_duration;        // time the replay took, not counting the final wait for replies
+    mahi::util::Time        max_lag;                // longest a write went out after it was due
+    std::vector<ReplayDiff> diffs;                  // the first REPLAY_MAX_DIFFS differences
+
+    /// returns whether every reply came back as recorded
+    bool matches() const { return mismatched == 0; }
+};
+
+/// Plays a recorded session (see CaptureWriter) back into a board, or a stand-in for one like
+/// UecuEmulator, and compares the replies it sends back with the recorded ones. The writes of
+/// one port of the capture are sent in their recorded order, either with their recorded timing,
+/// sped up, or as fast as the link takes them. Replies are read in between writes, so a
+/// stand-in is never held up by a full receive buffer.
+class SessionReplay {
+public:
+    /// SessionReplay constructor
+    SessionReplay();
+    /// loads the writes and replies of port port_ from a capture file
+    bool load(const std::string& filename_, unsigned char port_ = 0);
+    /// sets how fast the session is played back. 1 keeps the recorded timing, 2 plays it twice as
+    /// fast, and so on. 0 sends every write as soon as the previous one went out (1 by default)
+    void set_speed(double speed_);
+    /// sets how long to keep waiting for replies after the last write (500 ms by default)
+    void set_reply_timeout(mahi::util::Time reply_timeout_);
+    /// plays the loaded session into transport_, which must be open, and compares the replies
+    ReplayResult run(Transport& transport_);
+    /// returns the number of loaded writes
+    size_t get_write_count();
+    /// returns the number of loaded replies
+    size_t get_reply_count();
+
+private:
+    /// a recorded write
+    struct Write {
+        std::uint64_t time_ns;  // when it was written (ns)
+        size_t        offset;   // where its bytes start in m_tx_bytes
+        size_t        size;     // number of bytes
+    };
+
+    /// reads whatever replies arrive within timeout_ into the parser
+    void receive(Transport& transport_, mahi::util::Time timeout_);
+
+    std::vector<Write>         m_writes;         // recorded writes, in order
+    std::vector<unsigned char> m_tx_bytes;       // bytes of every recorded write
+    std::vector<Reply>         m_expected;       // recorded replies, in order
+    std::vector<Reply>         m_received;       // replies received during the replay
+    double                     m_speed;          // playback speed, 0 for as fast as possible
+    mahi::util::Time           m_reply_timeout;  // how long to wait for replies after the last write
+    unsigned char              m_rx_buffer[256]; // bytes received by the last read
+};
+
+}  // namespace fes
+}  // namespace mahi
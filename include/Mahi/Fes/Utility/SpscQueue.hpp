@@ -0,0 +1,65 @@
+// MIT License
+//
+// Copyright (c) 2020 Mechatronics and Haptic Interfaces Lab - Rice University
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// Author(s): Nathan Dunkelberger (nbd2@rice.edu)
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+
+namespace mahi {
+namespace fes {
+
+/// Bounded single-producer/single-consumer ring. Exactly one thread may push and exactly one
+/// (other) thread may pop. Neither side ever blocks or allocates: push fails when the ring is
+/// full and pop fails when it is empty. Capacity must be a power of two.
+template <typename T, size_t Capacity>
+class SpscQueue {
+    static_assert(Capacity > 0 && (Capacity & (Capacity - 1)) == 0, "SpscQueue capacity must be a power of two");
+
+public:
+    /// SpscQueue constructor
+    SpscQueue() : m_head(0), m_tail(0) {}
+    /// copies item_ into the ring. returns false (and drops item_) if the ring is full
+    bool push(const T& item_) {
+        size_t tail = m_tail.load(std::memory_order_relaxed);
+        if (tail - m_head.load(std::memory_order_acquire) == Capacity) return false;
+        m_items[tail & (Capacity - 1)] = item_;
+        m_tail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+    /// moves the oldest item into item_. returns false if the ring is empty
+    bool pop(T& item_) {
+        size_t head = m_head.load(std::memory_order_relaxed);
+        if (head == m_tail.load(std::memory_order_acquire)) return false;
+        item_ = m_items[head & (Capacity - 1)];
+        m_head.store(head + 1, std::memory_order_release);
+        return true;
+    }
+    /// returns the number of items in the ring (only exact when called from one of the two sides)
+    size_t size() const { return m_tail.load(std::memory_order_acquire) - m_head.load(std::memory_order_acquire); }
+    /// returns whether the ring is empty
+    bool empty() const { return size() == 0; }
+    /// returns the number of items the ring can hold
+    static constexpr size_t capacity() { return Capacity; }
+
+private:
+    T                   m_items[Capacity];  // storage for the items
+    std::atomic<size_t> m_head;             // index of the next item to pop (only written by the consumer)
+    std::atomic<size_t> m_tail;             // index of the next slot to push to (only written by the producer)
+};
+
+}  // namespace fes
+}  // namespace mahi
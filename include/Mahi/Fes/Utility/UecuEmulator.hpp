@@ -0,0 +1,163 @@
+// MIT License
+//
+// Copyright (c) 2020 Mechatronics and Haptic Interfaces Lab - Rice University
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// Author(s): Nathan Dunkelberger (nbd2@rice.edu)
+
+#pragma once
+
+#include <Mahi/Fes/Transport/Transport.hpp>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#define UECU_NUM_CHANNELS  4    // channels on one board
+#define UECU_MAX_SCHEDULES 4    // schedules one board can hold
+#define UECU_MAX_EVENTS    16   // events one board can hold
+
+// Error codes sent in the error reports of the emulator. The codes of the real UECU are in its
+// protocol documentation, which is not available, so these are only meaningful to the emulator
+#define UECU_ERR_CHECKSUM      0x01  // the checksum of a message was wrong
+#define UECU_ERR_UNKNOWN_MSG   0x02  // the message type is not supported
+#define UECU_ERR_LENGTH        0x03  // the message length does not match its type
+#define UECU_ERR_NO_SCHEDULE   0x04  // no schedule with the given id
+#define UECU_ERR_NO_EVENT      0x05  // no event with the given id
+#define UECU_ERR_FULL          0x06  // no room for another schedule or event
+#define UECU_ERR_CHANNEL       0x07  // the channel does not exist or was not set up
+#define UECU_ERR_DELAY         0x08  // an event delay does not fit in its schedule duration
+#define UECU_ERR_LIMIT         0x09  // a pulse width or amplitude was over the channel limit
+
+namespace mahi {
+namespace fes {
+
+/// Counters kept by a UecuEmulator
+struct UecuEmulatorStats {
+    std::uint64_t messages        = 0;  // valid messages received from the host
+    std::uint64_t checksum_errors = 0;  // messages that failed the checksum
+    std::uint64_t errors_reported = 0;  // error reports and event errors sent to the host
+    std::uint64_t replies         = 0;  // replies sent to the host (including error reports)
+    std::uint64_t discarded       = 0;  // bytes that did not belong to any message
+};
+
+/// Board side of the UECU serial protocol, without any hardware. The emulator reads the
+/// messages the host sends over a transport (the board end of a loopback pair, or the master
+/// end of a pty) and keeps the state a board would: channel setups, schedules and events with
+/// the ids it hands out, and their parameters. It answers the way a board does, with
+/// CreateScheduleReply, CreateEventReply and EventCommandReply messages and with error reports
+/// for anything it cannot act on, all signed with the same crc a board uses. This lets the
+/// Stimulator run with is_virtual_ = false, replies and all, where no board is connected.
+class UecuEmulator {
+public:
+    /// setup of a channel, as last sent with a channel setup message
+    struct ChannelState {
+        bool          configured    = false;  // whether a setup message was received
+        unsigned char max_amplitude = 0;      // amplitude limit
+        unsigned char max_pw        = 0;      // pulse width limit
+        unsigned int  ip_delay      = 0;      // interphase delay
+        unsigned char aspect        = 0;      // aspect ratio
+        unsigned char anode_cathode = 0;      // anode/cathode pair
+    };
+
+    /// a schedule created by the host
+    struct ScheduleState {
+        unsigned char id        = 0;      // id handed out in the CreateScheduleReply
+        unsigned char sync_char = 0;      // sync signal that starts the schedule
+        unsigned int  duration  = 0;      // schedule duration (ms)
+        bool          running   = false;  // whether the schedule was started and not halted
+    };
+
+    /// an event created by the host
+    struct EventState {
+        unsigned char id          = 0;  // id handed out in the CreateEventReply
+        unsigned char schedule_id = 0;  // schedule the event belongs to
+        unsigned int  delay       = 0;  // delay from the start of the schedule (ms)
+        unsigned char priority    = 0;  // priority of the event
+        unsigned char type        = 0;  // event type
+        unsigned char channel     = 0;  // channel of the board the event stimulates
+        unsigned char pulse_width = 0;  // current pulse width
+        unsigned char amplitude   = 0;  // current amplitude
+        unsigned char zone        = 0;  // unused
+    };
+
+    /// called with every valid message received from the host, before the emulator acts on it
+    typedef std::function<void(const unsigned char* message_, size_t size_)> MessageCallback;
+
+    /// UecuEmulator constructor. transport_ is the board's end of the link
+    UecuEmulator(Transport& transport_);
+    /// UecuEmulator destructor
+    ~UecuEmulator();
+    /// starts a thread that reads the host's messages from the transport and answers them
+    bool start();
+    /// stops the thread
+    void stop();
+    /// returns whether the thread is running
+    bool is_running();
+    /// handles size_ bytes received from the host, writing any replies to the transport. Use this
+    /// instead of start() to drive the emulator from the caller's thread
+    void feed(const unsigned char* data_, size_t size_);
+    /// sets a callback that sees every valid message (eg. to time when it arrived). Set it before
+    /// starting the emulator
+    void set_on_message(MessageCallback on_message_);
+    /// forgets all channel setups, schedules and events, as if the board was power cycled
+    void reset();
+    /// returns the setup of channel channel_ (0 to UECU_NUM_CHANNELS - 1)
+    ChannelState get_channel(unsigned char channel_);
+    /// returns the schedules that currently exist
+    std::vector<ScheduleState> get_schedules();
+    /// returns the events that currently exist
+    std::vector<EventState> get_events();
+    /// returns a snapshot of the emulator counters
+    UecuEmulatorStats get_stats();
+
+private:
+    /// loop run by the emulator thread
+    void read_loop();
+    /// takes in one byte from the host
+    void feed_byte(unsigned char byte_);
+    /// drops the first byte of m_frame, so that feed_byte looks for the start of a message in the rest
+    void resync();
+    /// acts on the complete message at the start of m_frame
+    void handle_message();
+    /// sends a reply of type_ carrying size_ bytes of data_
+    void send_reply(unsigned char type_, const unsigned char* data_, size_t size_);
+    /// sends an error report for a message of type failed_type_
+    void send_error(unsigned char error_code_, unsigned char failed_type_);
+    /// sends an event error for event_
+    void send_event_error(unsigned char error_code_, const EventState& event_);
+    /// returns the schedule with id_, or nullptr
+    ScheduleState* find_schedule(unsigned char id_);
+    /// returns the event with id_, or nullptr
+    EventState* find_event(unsigned char id_);
+    /// returns whether pw_ and amplitude_ are within the limits of channel_, sending an event
+    /// error for event_ if they are not
+    bool check_limits(const EventState& event_, unsigned char pw_, unsigned char amplitude_);
+
+    Transport&                 m_transport;                    // board end of the link
+    std::mutex                 m_mtx;                          // guards the board state and the parser
+    ChannelState               m_channels[UECU_NUM_CHANNELS];  // channel setups
+    std::vector<ScheduleState> m_schedules;                    // schedules that exist
+    std::vector<EventState>    m_events;                       // events that exist
+    std::vector<unsigned char> m_frame;                        // message being received
+    size_t                     m_checked = 0;                  // bytes of m_frame looked at so far
+    std::vector<unsigned char> m_reply;                        // reply being sent
+    UecuEmulatorStats          m_stats;                        // counters
+    MessageCallback            m_on_message;                   // sees every valid message, if set
+    std::thread                m_thread;                       // emulator thread
+    std::atomic<bool>          m_running;                      // whether the emulator thread should keep running
+};
+
+}  // namespace fes
+}  // namespace mahi
@@ -0,0 +1,128 @@
+// MIT License
+//
+// Copyright (c) 2020 Mechatronics and Haptic Interfaces Lab - Rice University
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// Author(s): Nathan Dunkelberger (nbd2@rice.edu)
+
+#pragma once
+
+#include <Mahi/Util.hpp>
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <vector>
+
+namespace mahi {
+namespace fes {
+
+/// One stimulation pulse fired by the simulated board
+struct SimPulse {
+    mahi::util::Time time;         // when the pulse fired
+    unsigned char    event_id;     // event that fired it (0 for an event command)
+    unsigned char    channel;      // channel of the board
+    unsigned char    pulse_width;  // pulse width it fired with
+    unsigned char    amplitude;    // amplitude it fired with
+    mahi::util::Time age;          // time since the host sent the parameters it fired with
+    bool             stale;        // whether newer parameters had been sent but not yet arrived
+};
+
+/// Counters kept by a UecuTimingSim
+struct UecuTimingSimStats {
+    std::uint64_t    messages     = 0;  // messages that arrived at the board
+    std::uint64_t    pulses       = 0;  // pulses fired
+    std::uint64_t    stale_pulses = 0;  // pulses fired with stale parameters
+    mahi::util::Time max_age;           // oldest parameters a pulse fired with
+    mahi::util::Time max_arrival;       // longest time from a message being sent to it arriving
+};
+
+/// Timing model of a UECU board, for working out offline when pulses fire and with which
+/// parameters. It is fed the bytes the host writes (eg. from a transport tap) along with when
+/// they were written. Each byte is charged its wire time at the baud rate, so a message only
+/// takes effect once its last byte has made it over. Schedules fire their events every period
+/// (the schedule duration) from the sync message on, each at its own delay into the period,
+/// and every pulse goes into a timeline. A pulse is stale when the host had already sent newer
+/// parameters for its event that were still on the wire. Schedule and event ids are handed out
+/// the same way a board (and UecuEmulator) does. Nothing is answered, so the host should run
+/// with is_virtual_ = true.
+class UecuTimingSim {
+public:
+    /// UecuTimingSim constructor. If charge_wire_time_ is false, messages take effect as soon
+    /// as they are sent
+    UecuTimingSim(unsigned int baud_rate_ = 9600, bool charge_wire_time_ = true);
+    /// UecuTimingSim destructor
+    ~UecuTimingSim();
+    /// takes in size_ bytes of data_ the host wrote at time_. time_ must not go backwards
+    void feed(mahi::util::Time time_, const unsigned char* data_, size_t size_);
+    /// runs the board up to end_time_, after the last bytes were fed
+    void finish(mahi::util::Time end_time_);
+    /// forgets all schedules, events and pulses
+    void reset();
+    /// returns the pulses fired so far, in order
+    const std::vector<SimPulse>& get_timeline();
+    /// writes the timeline to a csv file (time in s, event, channel, pw, amp, age in ms, stale)
+    bool write_timeline(const std::string& filename_);
+    /// returns the counters
+    UecuTimingSimStats get_stats();
+
+private:
+    struct SimSchedule {
+        unsigned char    id;         // schedule id
+        unsigned char    sync_char;  // sync signal that starts it
+        mahi::util::Time period;     // schedule duration
+        mahi::util::Time start;      // when it was started
+        bool             running;    // whether it is firing its events
+    };
+
+    struct SimEvent {
+        unsigned char    id;           // event id
+        unsigned char    schedule_id;  // schedule it belongs to
+        mahi::util::Time delay;        // delay into the schedule period
+        unsigned char    channel;      // channel of the board
+        unsigned char    pulse_width;  // current pulse width
+        unsigned char    amplitude;    // current amplitude
+        mahi::util::Time sent;         // when the host sent the current parameters
+        mahi::util::Time next_pulse;   // when it fires next, if its schedule is running
+    };
+
+    struct SimMessage {
+        mahi::util::Time           sent;     // when the host wrote it
+        mahi::util::Time           arrival;  // when its last byte arrived
+        std::vector<unsigned char> bytes;    // the complete message
+    };
+
+    /// fires the pulses and applies the messages that happen before time_
+    void advance(mahi::util::Time time_);
+    /// makes the changes of message_ to the board
+    void apply(const SimMessage& message_);
+    /// returns the first time at or after time_ that event_ fires in its running schedule_
+    mahi::util::Time first_pulse(const SimSchedule& schedule_, const SimEvent& event_, mahi::util::Time time_);
+    /// returns the schedule with id_, or nullptr
+    SimSchedule* find_schedule(unsigned char id_);
+    /// returns the event with id_, or nullptr
+    SimEvent* find_event(unsigned char id_);
+
+    mahi::util::Time           m_byte_time;         // wire time of one byte
+    bool                       m_charge_wire_time;  // whether bytes take time to go over the wire
+    mahi::util::Time           m_wire_free;         // when the wire is done with the bytes sent so far
+    mahi::util::Time           m_now;               // time up to which the board has run
+    std::vector<unsigned char> m_frame;             // message being put together
+    mahi::util::Time           m_frame_sent;        // when the first byte of m_frame was sent
+    std::deque<SimMessage>     m_in_flight;         // messages sent but not yet applied
+    std::vector<SimSchedule>   m_schedules;         // schedules on the board
+    std::vector<SimEvent>      m_events;            // events on the board
+    std::vector<SimPulse>      m_timeline;          // pulses fired so far
+    UecuTimingSimStats         m_stats;             // counters
+};
+
+}  // namespace fes
+}  // namespace mahi
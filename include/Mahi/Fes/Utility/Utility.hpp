@@ -19,8 +19,6 @@
 #include <string>
 #include <vector>
 
-#include "Windows.h"
-
 // Message commands for sending serial packets
 #define TRIGGER_SETUP_MSG         0x03
 #define HALT_MSG                  0x04
@@ -46,11 +44,18 @@
 #define SRC_ADR  0x80
 
 // Length of messages which should never be changed
-#define SYNC_MSG_LEN     0x01
-#define CREATE_SCHED_LEN 0x03
-#define CH_SET_LEN       0x07
-#define CR_EVT_LEN       0x09
-#define HALT_LEN         0x01
+#define SYNC_MSG_LEN            0x01
+#define CREATE_SCHED_LEN        0x03
+#define CH_SET_LEN              0x07
+#define CR_EVT_LEN              0x09
+#define HALT_LEN                0x01
+#define DEL_SCHED_LEN           0x01
+#define CHANGE_SCHED_LEN        0x04
+#define CHANGE_SCHED_STATE_LEN  0x02
+#define DELETE_EVENT_LEN        0x01
+#define CHANGE_EVENT_SCHED_LEN  0x05
+#define CHANGE_EVENT_PARAMS_LEN 0x04
+#define STIM_EVENT_COMMAND_LEN  0x06
 
 // Anode Cathode pairs for channels 1-4
 #define AN_CA_1 0x01
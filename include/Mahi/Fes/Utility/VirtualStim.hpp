@@ -16,10 +16,10 @@
 
 #pragma once
 
-#include <Windows.h>
-
+#include <Mahi/Fes/Transport/Transport.hpp>
 #include <Mahi/Gui.hpp>
 #include <Mahi/Util.hpp>
+#include <memory>
 #include <string>
 #include <thread>
 
@@ -50,17 +50,14 @@ private:
 
     /// opens the serial port as indicated by the input argument
     bool open_port();
-    /// configures the comport based on general settings
-    bool configure_port();
     /// function to format the message into a way that outputs nicely
     std::vector<std::string> fmt_msg(std::vector<unsigned char> message);
     /// adds a "monitor" for a specific type of message class to the gui
     void add_monitor(SerialMessage ser_msg);
 
     unsigned int                          m_msg_count = 0;    // total number of messages received
-    DCB                                   m_dcbSerialParams;  // parameters to handle serial port communication
-    std::string                           m_com_port;         // comport number - should be formatted COMX or COMXX
-    HANDLE                                m_hComm;            // serial handle to the desired comport
+    std::string                           m_com_port;         // comport number - should be formatted COMX or COMXX (or /dev/ttyX)
+    std::unique_ptr<Transport>            m_transport;        // transport to the desired comport
     bool                                  m_open  = true;     // whether or not the application is open
     bool                                  m_pause = false;    // pauses the recent messages feed
     std::thread                           m_poll_thread;      // thread for handling continuous polling
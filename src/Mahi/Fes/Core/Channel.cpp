@@ -14,11 +14,8 @@
 //
 // Author(s): Nathan Dunkelberger (nbd2@rice.edu)
 
-#include <Windows.h>
-#include <tchar.h>
-
 #include <Mahi/Fes/Core/Channel.hpp>
-#include <Mahi/Fes/Core/WriteMessage.hpp>
+#include <Mahi/Fes/Core/Frame.hpp>
 #include <Mahi/Fes/Utility/Utility.hpp>
 #include <Mahi/Util.hpp>
 
@@ -44,25 +41,15 @@ Channel::Channel(const std::string& name_, unsigned char channel_num_, unsigned
 
 Channel::~Channel() {}
 
-bool Channel::setup_channel(HANDLE serial_handle_, Time delay_time_) {
-    std::vector<unsigned char> ip_delay_bytes = int_to_twobytes(m_ip_delay);
-
-    std::vector<unsigned char> setup = {DEST_ADR,                // Destination
-                                        SRC_ADR,                 // Source
-                                        CHANNEL_SETUP_MSG,       // Msg type
-                                        CH_SET_LEN,              // Msg len
-                                        m_board_channel_num,             // Channel
-                                        (unsigned char)m_max_amp,  // AmpLim
-                                        (unsigned char)m_max_pw,   // PWLim
-                                        ip_delay_bytes[0],       // IP delay (byte 1)
-                                        ip_delay_bytes[1],       // IP delay (byte 2)
-                                        ONE_TO_ONE,              // Aspect
-                                        m_an_ca_nums,              // Anode Cathode
-                                        0x00};                   // Checksum
-
-    WriteMessage setup_message(setup);
-
-    if (setup_message.write(serial_handle_, "Setting Up Channel")) {
+bool Channel::setup_channel(Transport& transport_, Time delay_time_) {
+    ChannelSetupFrame setup_message(m_board_channel_num,        // Channel
+                                    (unsigned char)m_max_amp,   // AmpLim
+                                    (unsigned char)m_max_pw,    // PWLim
+                                    m_ip_delay,                 // IP delay
+                                    ONE_TO_ONE,                 // Aspect
+                                    m_an_ca_nums);              // Anode Cathode
+
+    if (setup_message.write(transport_, "Setting Up Channel")) {
         // Sleep for delay time to allow the board to process
         sleep(delay_time_);
         return true;
@@ -16,10 +16,11 @@
 
 #include <Mahi/Fes/Core/Channel.hpp>
 #include <Mahi/Fes/Core/Event.hpp>
+#include <Mahi/Fes/Core/Frame.hpp>
 #include <Mahi/Fes/Core/Stimulator.hpp>
-#include <Mahi/Fes/Core/WriteMessage.hpp>
 #include <Mahi/Fes/Utility/Utility.hpp>
 #include <Mahi/Fes/Utility/Communication.hpp>
+#include <Mahi/Fes/Utility/ReplyDispatcher.hpp>
 #include <Mahi/Util.hpp>
 #include <queue>
 
@@ -28,10 +29,10 @@ using namespace mahi::util;
 namespace mahi {
 namespace fes {
 
-Event::Event(HANDLE& hComm_, unsigned char schedule_id_, int delay_time_, Channel channel_,
+Event::Event(Transport* transport_, unsigned char schedule_id_, int delay_time_, Channel channel_,
              unsigned char event_id_, bool is_virtual_, unsigned int pulse_width_, unsigned int amplitude_,
              unsigned char event_type_, unsigned char priority_, unsigned char zone_) :
-    m_hComm(hComm_),
+    m_transport(transport_),
     m_schedule_id(schedule_id_),
     m_delay_time(delay_time_),
     m_channel(channel_),
@@ -45,38 +46,31 @@ Event::Event(HANDLE& hComm_, unsigned char schedule_id_, int delay_time_, Channe
     m_event_id(event_id_),
     m_max_amplitude(m_channel.get_max_amplitude()),
     m_max_pulse_width(m_channel.get_max_pulse_width()),
-    m_zone(zone_) {
+    m_zone(zone_),
+    m_params_frame(event_id_, 0x00, 0x00) {
     create_event();
 }
 
 Event::~Event() {}
 
 bool Event::create_event() {
-    std::vector<unsigned char> delay_time_chars = int_to_twobytes(m_delay_time);
-
-    std::vector<unsigned char> create_event = {DEST_ADR,             // Destination
-                                               SRC_ADR,              // Source
-                                               CREATE_EVENT_MSG,     // Msg type
-                                               CR_EVT_LEN,           // Message length
-                                               m_schedule_id,          // Schedule ID
-                                               delay_time_chars[0],  // Delay time (byte 1)
-                                               delay_time_chars[1],  // Delay time (byte 2)
-                                               m_priority,             // priority (default none)
-                                               STIM_EVENT,           // Event type
-                                               m_channel.get_board_channel_num(),   // Channel number
-                                               (unsigned char)m_pulse_width,  // Pulse Width
-                                               (unsigned char)m_amplitude,    // Amplitude
-                                               m_zone,                        // Zone
-                                               0x00};                       // Checksum Placeholder
-
-    WriteMessage create_event_message(create_event);
-
-    if (create_event_message.write(m_hComm, "Creating Event")) {
+    CreateEventFrame create_event_message(m_schedule_id,                       // Schedule ID
+                                          m_delay_time,                        // Delay time
+                                          m_priority,                          // priority (default none)
+                                          STIM_EVENT,                          // Event type
+                                          m_channel.get_board_channel_num(),   // Channel number
+                                          (unsigned char)m_pulse_width,        // Pulse Width
+                                          (unsigned char)m_amplitude,          // Amplitude
+                                          m_zone);                             // Zone
+
+    if (create_event_message.write(*m_transport, "Creating Event")) {
         sleep(milliseconds(100));
         if (!m_is_virtual){
-            ReadMessage event_created_msg(read_message(m_hComm, true));
-            if (event_created_msg.is_valid()){
-                set_event_id(event_created_msg.get_data()[0]);
+            Reply           reply_buffer;
+            ReadMessageView   event_created_msg = read_message(*m_transport, reply_buffer, true);
+            EventCreatedReply event_created;
+            if (event_created_msg.is_valid() && decode_reply(event_created_msg, event_created)){
+                set_event_id(event_created.event_id);
             }
             else{
                 LOG(Error) << "Event created return message (below) either invalid or an error. Returning false.";
@@ -122,47 +116,48 @@ void Event::set_pulsewidth(unsigned int pulsewidth_) {
 
 unsigned int Event::get_pulsewidth() { return m_pulse_width; }
 
-bool Event::update() {
-    std::vector<unsigned char> edit_event = {DEST_ADR,                    // Destination
-                                             SRC_ADR,                     // Source
-                                             CHANGE_EVENT_PARAMS_MSG,     // Msg type
-                                             CHANGE_EVENT_PARAMS_LEN,     // Msg len
-                                             m_event_id,                    // Event ID
-                                             (unsigned char)m_pulse_width,  // Pulsewidth to update
-                                             (unsigned char)m_amplitude,    // Amplitude to update
-                                             0x00,   // Placeholder for other parameters
-                                             0x00};  // Checksum placeholder
-                                             
-    if((m_last_pw != m_pulse_width) || (m_last_amp != m_amplitude)){
-        m_last_pw  = m_pulse_width;
-        m_last_amp = m_amplitude;
-
-        WriteMessage edit_event_message(edit_event);
-
-        if (edit_event_message.write(m_hComm, "NONE")) {
-            return true;
-        } else {
-            return false;
-        }
-    }
-    else return true;
+unsigned int Event::get_delay_time() { return m_delay_time; }
+
+unsigned int Event::get_max_amplitude() { return m_max_amplitude; }
+
+unsigned int Event::get_max_pulsewidth() { return m_max_pulse_width; }
+
+bool Event::append_update(std::vector<unsigned char>& buffer_) {
+    return append_update(buffer_, m_pulse_width, m_amplitude);
+}
+
+bool Event::append_update(std::vector<unsigned char>& buffer_, unsigned int pulse_width_, unsigned int amplitude_) {
+    if ((m_last_pw == pulse_width_) && (m_last_amp == amplitude_)) return false;
+
+    m_last_pw  = pulse_width_;
+    m_last_amp = amplitude_;
+
+    m_params_frame.set_params((unsigned char)pulse_width_, (unsigned char)amplitude_);
+    m_params_frame.append_to(buffer_);
+
+    return true;
 }
 
 void Event::set_event_id(unsigned char event_id_){
-    m_event_id = event_id_;
+    m_event_id     = event_id_;
+    m_params_frame = ChangeEventParamsFrame(m_event_id, (unsigned char)m_last_pw, (unsigned char)m_last_amp);
 }
 
-bool Event::delete_event() {
-    std::vector<unsigned char> del_evt = {DEST_ADR,          // Destination
-                                          SRC_ADR,           // Source
-                                          DELETE_EVENT_MSG,  // Msg type
-                                          DELETE_EVENT_LEN,  // Msg len
-                                          m_event_id,          // Event ID
-                                          0x00};             // Checksum placeholder
+bool Event::change_delay_time(unsigned int delay_time_) {
+    ChangeEventScheduleFrame change_evt_sched_message(m_event_id, m_schedule_id, delay_time_, m_priority);
 
-    WriteMessage del_evt_message(del_evt);
+    if (change_evt_sched_message.write(*m_transport, "NONE")) {
+        m_delay_time = delay_time_;
+        return true;
+    } else {
+        return false;
+    }
+}
+
+bool Event::delete_event() {
+    DeleteEventFrame del_evt_message(m_event_id);
 
-    if (del_evt_message.write(m_hComm, "Deleting Event")) {
+    if (del_evt_message.write(*m_transport, "Deleting Event", true)) {
         return true;
     } else {
         return false;
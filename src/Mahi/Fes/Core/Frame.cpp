@@ -14,56 +14,51 @@
 //
 // Author(s): Nathan Dunkelberger (nbd2@rice.edu)
 
-#include <Mahi/Fes/Core/WriteMessage.hpp>
+#include <Mahi/Fes/Core/Frame.hpp>
 #include <Mahi/Util.hpp>
+#include <cstring>
 
 using namespace mahi::util;
 
 namespace mahi {
 namespace fes {
 
-WriteMessage::WriteMessage(std::vector<unsigned char> message) {
-    m_message             = message;
-    m_size                = m_message.size();
-    m_checksum            = calc_checksum();
-    m_message[m_size - 1] = m_checksum;
-}
+// the sync message of the default sync character, worked out by the compiler
+static_assert(checksum_of(DEST_ADR, SRC_ADR, SYNC_MSG, SYNC_MSG_LEN, 0xAA) == 0xB4,
+              "checksum_of does not match the UECU checksum");
 
-unsigned char WriteMessage::calc_checksum() {
+unsigned char frame_checksum(const unsigned char* data_, size_t size_) {
     int sum = 0;
     // sum of bytes
-    for (int i = 0; i < m_size - 1; i++) {
-        sum += m_message[i];
+    for (size_t i = 0; i < size_; i++) {
+        sum += data_[i];
     }
     int csum1 = (0x00FF & sum);          // get just lower byte of the sum
     int csum2 = (sum >> 8);              // get the carry byte of the sum (shift right by 8 bits)
     int csum  = (csum1 + csum2) ^ 0xFF;  // add carry byte to lower byte and invert
-    return csum;
+    return (unsigned char)csum;
 }
 
-unsigned char WriteMessage::get_checksum() { return m_checksum; }
-
-bool WriteMessage::write(HANDLE hComm, const std::string& activity) {
-    // dont log anything if the input string is "NONE"
-    bool log_message = (activity.compare("NONE") != 0);
-
-    // Captures how many bits were written
-    DWORD dwBytesWritten = 0;
+bool write_frame(Transport& transport_, const unsigned char* data_, size_t size_, const char* activity_,
+                 bool priority_) {
+    // dont log anything if the activity is "NONE"
+    bool log_message = std::strcmp(activity_, "NONE") != 0;
 
-    // write the file if possible
-    if (!WriteFile(hComm, get_message_pointer(), (DWORD)m_size, &dwBytesWritten, NULL)) {
+    // write the message if possible
+    bool written = priority_ ? transport_.write_priority(data_, size_) : transport_.write(data_, size_);
+    if (!written) {
         // log that the activity was successful or unsuccessful
         if (log_message) {
-            LOG(Error) << "Error " << activity;
+            LOG(Error) << "Error " << activity_;
         }
         return false;
     } else {
         if (log_message) {
-            LOG(Info) << activity << " was Successful.";
+            LOG(Info) << activity_ << " was Successful.";
         }
         return true;
     }
 }
 
 }  // namespace fes
-}  // namespace mahi
\ No newline at end of file
+}  // namespace mahi
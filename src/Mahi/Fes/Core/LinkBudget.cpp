@@ -0,0 +1,58 @@
+// MIT License
+//
+// Copyright (c) 2020 Mechatronics and Haptic Interfaces Lab - Rice University
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// Author(s): Nathan Dunkelberger (nbd2@rice.edu)
+
+#include <Mahi/Fes/Core/LinkBudget.hpp>
+#include <cmath>
+#include <cstdint>
+
+using namespace mahi::util;
+
+namespace mahi {
+namespace fes {
+
+LinkBudget compute_link_budget(unsigned int baud_rate_, unsigned int period_ms_, size_t num_events_) {
+    // nothing fits in an empty period or over a link that sends nothing, and the ratios below would
+    // not be finite
+    if (baud_rate_ == 0 || period_ms_ == 0) {
+        LinkBudget budget;
+        budget.period   = milliseconds(period_ms_);
+        budget.events   = num_events_;
+        budget.headroom = -1.0;
+        budget.valid    = false;
+        return budget;
+    }
+
+    // 8N1, so every byte is 10 bits on the wire
+    double frame_us  = CHANGE_EVENT_PARAMS_SIZE * 10.0 * 1e6 / baud_rate_;
+    double period_us = period_ms_ * 1000.0;
+
+    LinkBudget budget;
+    budget.period          = microseconds((std::int64_t)period_us);
+    budget.wire_time       = microseconds((std::int64_t)(frame_us * num_events_));
+    budget.events          = num_events_;
+    budget.events_per_tick = (size_t)(period_us / frame_us);
+    budget.headroom        = 1.0 - frame_us * num_events_ / period_us;
+
+    // when not even one update fits, or there are more events than fit, spread them over as many
+    // periods as it takes
+    if (!budget.fits()) {
+        budget.rate_divider = (size_t)std::ceil(frame_us * num_events_ / period_us);
+    }
+    return budget;
+}
+
+}  // namespace fes
+}  // namespace mahi
@@ -18,6 +18,7 @@
 #include <Mahi/Fes/Utility/Utility.hpp>
 #include <Mahi/Util.hpp>
 #include <algorithm>
+#include <utility>
 
 using namespace mahi::util;
 
@@ -25,7 +26,7 @@ namespace mahi {
 namespace fes {
 
 ReadMessage::ReadMessage(std::vector<unsigned char> message) {
-    m_message           = message;
+    m_message           = std::move(message);
     m_size              = m_message.size();
     if(m_size > 1){
         std::vector<unsigned char> crc(m_message.end()-2, m_message.end());
@@ -41,7 +42,7 @@ ReadMessage::ReadMessage(std::vector<unsigned char> message) {
 }
 
 ReadMessage::ReadMessage(std::vector<unsigned char> message, size_t msg_count) {
-    m_message           = message;
+    m_message           = std::move(message);
     m_size              = m_message.size();
     if(m_size > 1){
         std::vector<unsigned char> crc(m_message.end()-2, m_message.end());
@@ -57,36 +58,101 @@ ReadMessage::ReadMessage(std::vector<unsigned char> message, size_t msg_count) {
     m_data = data_vec;
 }
 
-std::vector<unsigned char> ReadMessage::calc_crc(){
-    auto cnt = m_message.size()-2;
-    int crc = CRC_SEED; // initialize CRC
-    int i, pos;
-    pos = 0;
-    while (cnt-- > 0){
-        crc = crc ^ m_message[pos++];
-        for (i=8; i>0; i--){
-            if (crc & 0x0001){
-                crc = (crc >> 1) ^ CRC_POLY;
-            }
-            else{
-                crc >>= 1;
-            }
-        }
+const std::uint16_t CRC_TABLE[256] = {
+    0x0000, 0xC0C1, 0xC181, 0x0140, 0xC301, 0x03C0, 0x0280, 0xC241,
+    0xC601, 0x06C0, 0x0780, 0xC741, 0x0500, 0xC5C1, 0xC481, 0x0440,
+    0xCC01, 0x0CC0, 0x0D80, 0xCD41, 0x0F00, 0xCFC1, 0xCE81, 0x0E40,
+    0x0A00, 0xCAC1, 0xCB81, 0x0B40, 0xC901, 0x09C0, 0x0880, 0xC841,
+    0xD801, 0x18C0, 0x1980, 0xD941, 0x1B00, 0xDBC1, 0xDA81, 0x1A40,
+    0x1E00, 0xDEC1, 0xDF81, 0x1F40, 0xDD01, 0x1DC0, 0x1C80, 0xDC41,
+    0x1400, 0xD4C1, 0xD581, 0x1540, 0xD701, 0x17C0, 0x1680, 0xD641,
+    0xD201, 0x12C0, 0x1380, 0xD341, 0x1100, 0xD1C1, 0xD081, 0x1040,
+    0xF001, 0x30C0, 0x3180, 0xF141, 0x3300, 0xF3C1, 0xF281, 0x3240,
+    0x3600, 0xF6C1, 0xF781, 0x3740, 0xF501, 0x35C0, 0x3480, 0xF441,
+    0x3C00, 0xFCC1, 0xFD81, 0x3D40, 0xFF01, 0x3FC0, 0x3E80, 0xFE41,
+    0xFA01, 0x3AC0, 0x3B80, 0xFB41, 0x3900, 0xF9C1, 0xF881, 0x3840,
+    0x2800, 0xE8C1, 0xE981, 0x2940, 0xEB01, 0x2BC0, 0x2A80, 0xEA41,
+    0xEE01, 0x2EC0, 0x2F80, 0xEF41, 0x2D00, 0xEDC1, 0xEC81, 0x2C40,
+    0xE401, 0x24C0, 0x2580, 0xE541, 0x2700, 0xE7C1, 0xE681, 0x2640,
+    0x2200, 0xE2C1, 0xE381, 0x2340, 0xE101, 0x21C0, 0x2080, 0xE041,
+    0xA001, 0x60C0, 0x6180, 0xA141, 0x6300, 0xA3C1, 0xA281, 0x6240,
+    0x6600, 0xA6C1, 0xA781, 0x6740, 0xA501, 0x65C0, 0x6480, 0xA441,
+    0x6C00, 0xACC1, 0xAD81, 0x6D40, 0xAF01, 0x6FC0, 0x6E80, 0xAE41,
+    0xAA01, 0x6AC0, 0x6B80, 0xAB41, 0x6900, 0xA9C1, 0xA881, 0x6840,
+    0x7800, 0xB8C1, 0xB981, 0x7940, 0xBB01, 0x7BC0, 0x7A80, 0xBA41,
+    0xBE01, 0x7EC0, 0x7F80, 0xBF41, 0x7D00, 0xBDC1, 0xBC81, 0x7C40,
+    0xB401, 0x74C0, 0x7580, 0xB541, 0x7700, 0xB7C1, 0xB681, 0x7640,
+    0x7200, 0xB2C1, 0xB381, 0x7340, 0xB101, 0x71C0, 0x7080, 0xB041,
+    0x5000, 0x90C1, 0x9181, 0x5140, 0x9301, 0x53C0, 0x5280, 0x9241,
+    0x9601, 0x56C0, 0x5780, 0x9741, 0x5500, 0x95C1, 0x9481, 0x5440,
+    0x9C01, 0x5CC0, 0x5D80, 0x9D41, 0x5F00, 0x9FC1, 0x9E81, 0x5E40,
+    0x5A00, 0x9AC1, 0x9B81, 0x5B40, 0x9901, 0x59C0, 0x5880, 0x9841,
+    0x8801, 0x48C0, 0x4980, 0x8941, 0x4B00, 0x8BC1, 0x8A81, 0x4A40,
+    0x4E00, 0x8EC1, 0x8F81, 0x4F40, 0x8D01, 0x4DC0, 0x4C80, 0x8C41,
+    0x4400, 0x84C1, 0x8581, 0x4540, 0x8701, 0x47C0, 0x4680, 0x8641,
+    0x8201, 0x42C0, 0x4380, 0x8341, 0x4100, 0x81C1, 0x8081, 0x4040
+};
+
+unsigned int update_crc(unsigned int crc_, const unsigned char* data_, size_t size_) {
+    for (size_t i = 0; i < size_; i++) {
+        crc_ = update_crc(crc_, data_[i]);
+    }
+    return crc_;
+}
+
+unsigned int calc_crc(const unsigned char* data_, size_t size_) { return update_crc(CRC_SEED, data_, size_); }
+
+namespace {
+/// returns whether the last two bytes of a reply of size_ bytes hold crc_
+bool crc_at_end(const unsigned char* reply_, size_t size_, unsigned int crc_) {
+    return reply_[size_ - 2] == (unsigned char)(crc_ & 0xFF) && reply_[size_ - 1] == (unsigned char)(crc_ >> 8);
+}
+}  // namespace
+
+size_t check_crcs(const unsigned char* const* replies_, const size_t* sizes_, size_t count_, bool* valid_) {
+    // the replies do not depend on each other, so the processor already overlaps the table
+    // lookups of one with those of the next. Keeping the loop free of anything else (no
+    // allocation, no logging) is what makes this quicker than going through ReadMessage
+    size_t matched = 0;
+    for (size_t i = 0; i < count_; i++) {
+        valid_[i] = sizes_[i] > 2 && crc_at_end(replies_[i], sizes_[i], calc_crc(replies_[i], sizes_[i] - 2));
+        matched += valid_[i];
     }
-    std::vector<unsigned char> crc_bytes = int_to_twobytes(crc);
-    return {crc_bytes[1], crc_bytes[0]};
+    return matched;
+}
+
+bool is_reply_type(unsigned char type_) {
+    switch (type_) {
+        case ERROR_REPORT_MSG:
+        case EVENT_ERROR_MSG:
+        case CREATE_SCHEDULE_REPLY_MSG:
+        case CREATE_EVENT_REPLY_MSG:
+        case EVENT_COMMAND_REPLY_MSG:
+            return true;
+        default:
+            return false;
+    }
+}
+
+std::vector<unsigned char> ReadMessage::calc_crc(){
+    unsigned int crc = m_size > 2 ? fes::calc_crc(&m_message[0], m_size - 2) : CRC_SEED;
+    return {(unsigned char)(crc & 0xFF), (unsigned char)(crc >> 8)};
+}
+
+bool ReadMessage::crc_matches() {
+    if (m_size <= 2) return m_crc == calc_crc();
+    return crc_at_end(&m_message[0], m_size, fes::calc_crc(&m_message[0], m_size - 2));
 }
 
 unsigned char ReadMessage::get_read_message_type() { return m_read_message_type; }
 
 bool ReadMessage::is_valid() {
-    if (calc_crc() != m_crc) {
+    if (!crc_matches()) {
         print_message(calc_crc());
         print_message(m_crc);
         LOG(Error) << "Read checksum is wrong; message is likely invalid.";
         return false;
-    } else if (!binary_search(valid_msg_types.begin(), valid_msg_types.end(),
-                              m_read_message_type)) {
+    } else if (!is_reply_type(m_read_message_type)) {
         LOG(Error) << "Message type " << m_read_message_type
                    << " is unknown. Cannot interpret message.";
         return false;
@@ -98,5 +164,46 @@ std::vector<unsigned char> ReadMessage::get_data(){
     return m_data;
 }
 
+ReadMessageView::ReadMessageView() : m_message(nullptr), m_size(0) {}
+
+ReadMessageView::ReadMessageView(const unsigned char* message_, size_t size_) : m_message(message_), m_size(size_) {}
+
+bool ReadMessageView::empty() const { return m_size == 0; }
+
+const unsigned char* ReadMessageView::get_message_pointer() const { return m_message; }
+
+size_t ReadMessageView::get_size() const { return m_size; }
+
+unsigned char ReadMessageView::get_read_message_type() const { return m_size > 6 ? m_message[6] : 0x00; }
+
+const unsigned char* ReadMessageView::get_data() const { return m_size > 8 ? m_message + 8 : nullptr; }
+
+size_t ReadMessageView::get_data_size() const { return m_size > 10 ? m_size - 10 : 0; }
+
+unsigned int ReadMessageView::get_crc() const {
+    return m_size > 1 ? (unsigned int)m_message[m_size - 2] | ((unsigned int)m_message[m_size - 1] << 8) : 0;
+}
+
+bool ReadMessageView::crc_matches() const {
+    return m_size > 2 && crc_at_end(m_message, m_size, fes::calc_crc(m_message, m_size - 2));
+}
+
+bool ReadMessageView::is_valid() const {
+    if (!crc_matches()) {
+        LOG(Error) << "Read checksum is wrong; message is likely invalid.";
+        return false;
+    } else if (!is_reply_type(get_read_message_type())) {
+        LOG(Error) << "Message type " << get_read_message_type() << " is unknown. Cannot interpret message.";
+        return false;
+    }
+    return true;
+}
+
+std::vector<unsigned char> ReadMessageView::get_message() const {
+    return std::vector<unsigned char>(m_message, m_message + m_size);
+}
+
+ReadMessage ReadMessageView::to_message() const { return ReadMessage(get_message()); }
+
 }  // namespace fes
 }  // namespace mahi
\ No newline at end of file
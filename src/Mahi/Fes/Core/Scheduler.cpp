@@ -15,7 +15,7 @@
 // Author(s): Nathan Dunkelberger (nbd2@rice.edu)
 
 #include <Mahi/Fes/Core/Scheduler.hpp>
-#include <Mahi/Fes/Core/WriteMessage.hpp>
+#include <Mahi/Fes/Core/Frame.hpp>
 #include <Mahi/Fes/Utility/Utility.hpp>
 #include <Mahi/Util.hpp>
 
@@ -24,34 +24,61 @@ using namespace mahi::util;
 namespace mahi {
 namespace fes {
 
-Scheduler::Scheduler() : m_id(0x01) {}
+static_assert(ChangeEventParamsFrame::size() == CHANGE_EVENT_PARAMS_SIZE,
+              "the link budget assumes a different event update size");
+
+namespace {
+// a mailbox slot packs the pw and amplitude into one word so that a post is a single atomic
+// store, and the reader can never see the pw of one post with the amplitude of another
+const std::uint32_t MAILBOX_FULL  = 0x80000000;  // set while the slot holds values not yet sent
+const std::uint32_t MAILBOX_MASK  = 0x7FFF;      // each value gets 15 bits
+const unsigned int  MAILBOX_SHIFT = 15;          // the pw sits above the amplitude
+}  // namespace
+
+Scheduler::Scheduler() :
+    m_id(0x01),
+    m_enabled(false),
+    m_paused(false),
+    m_transport(nullptr),
+    m_sync_frame(0x00),
+    m_halt_frame(0x01),
+    m_del_sched_frame(0x01),
+    m_pause_frame(0x01, false),
+    m_resume_frame(0x01, true),
+    m_update_count(0),
+    m_duration(50),
+    m_event_spacing(5),
+    m_link_policy(LinkPolicy::RoundRobin),
+    m_tick(0),
+    m_next_event(0),
+    m_max_queued(CHANGE_EVENT_PARAMS_SIZE),
+    m_held_back_count(0),
+    m_stop_request(-1),
+    m_stop_latency(0),
+    m_io_running(false),
+    m_io_failed(false) {
+    for (size_t i = 0; i < MAX_SCHED_EVENTS; i++) m_mailbox[i].store(0);
+    // room for an update of every event, so that updating never allocates
+    m_update_buffer.reserve(MAX_SCHED_EVENTS * CHANGE_EVENT_PARAMS_SIZE);
+    m_stop_buffer.reserve(MAX_SCHED_EVENTS * CHANGE_EVENT_PARAMS_SIZE);
+}
 
 Scheduler::~Scheduler() { disable(); }
 
-bool Scheduler::create_scheduler(HANDLE& hComm_, const unsigned char sync_char_, unsigned int duration,
+bool Scheduler::create_scheduler(Transport& transport_, const unsigned char sync_char_, unsigned int duration,
                                  Time setup_time) {
-    m_sync_char = sync_char_;
-
-    m_hComm = hComm_;
-
-    DWORD dwBytesWritten = 0;  // Captures how many bits were written
+    m_sync_char  = sync_char_;
+    m_sync_frame = SyncFrame(m_sync_char);
+    m_duration  = duration;
 
-    // convert the input duration (int) into two bytes that we can send over a message
-    std::vector<unsigned char> duration_chars = int_to_twobytes(duration);
+    m_transport = &transport_;
+    m_budget    = compute_link_budget(m_transport->get_baud_rate(), m_duration, m_events.size());
 
-    std::vector<unsigned char> crt_sched = {DEST_ADR,             // Destination
-                                            SRC_ADR,              // Source
-                                            CREATE_SCHEDULE_MSG,  // Msg type
-                                            CREATE_SCHED_LEN,     // Message length
-                                            m_sync_char,          // sync character
-                                            duration_chars[0],    // schedule duration (byte 1)
-                                            duration_chars[1],    // schedule duration (byte 2)
-                                            0x00};                // checksum placeholder
+    CreateScheduleFrame crt_sched_message(m_sync_char, duration);
 
-    WriteMessage crt_sched_message(crt_sched);
-
-    if (crt_sched_message.write(m_hComm, "Creating Scheduler")) {
+    if (crt_sched_message.write(*m_transport, "Creating Scheduler")) {
         m_enabled = true;
+        m_paused  = false;
         sleep(setup_time);
         return true;
     } else {
@@ -61,25 +88,62 @@ bool Scheduler::create_scheduler(HANDLE& hComm_, const unsigned char sync_char_,
 
 bool Scheduler::halt_scheduler() {
     if (is_enabled()) {
-        std::vector<unsigned char> halt = {DEST_ADR,  // Destination
-                                           SRC_ADR,   // Source
-                                           HALT_MSG,  // Msg type
-                                           HALT_LEN,  // Msg len
-                                           m_id,      // Schedule ID
-                                           0x00};     // Checksum placeholder
-
-        WriteMessage halt_message(halt);
+        Time stop_time = m_clock.get_elapsed_time();
 
-        return halt_message.write(m_hComm, "Schedule Closing");
+        // the halt was encoded when the schedule id was set, so stopping is a single write
+        if (!m_halt_frame.write(*m_transport, "Schedule Closing", true)) return false;
+        record_stop(stop_time);
+        return true;
     } else {
         LOG(Error) << "Scheduler was not enabled. Nothing to disable";
         return false;
     }
 }
 
+bool Scheduler::pause() {
+    if (!is_enabled()) {
+        LOG(Error) << "Scheduler was not enabled. Nothing to pause";
+        return false;
+    }
+    if (m_paused) return true;
+    Time stop_time = m_clock.get_elapsed_time();
+
+    // like the halt, the pause was encoded when the schedule id was set
+    if (!m_pause_frame.write(*m_transport, "Pausing Schedule", true)) return false;
+    record_stop(stop_time);
+    m_paused = true;
+    return true;
+}
+
+bool Scheduler::resume() {
+    if (!is_enabled()) {
+        LOG(Error) << "Scheduler was not enabled. Nothing to resume";
+        return false;
+    }
+    if (!m_paused) return true;
+
+    // the resume goes ahead of any routine writes still waiting in the transport, the same as the
+    // pause, so the schedule does not sit stopped behind a backlog of updates
+    if (!m_resume_frame.write(*m_transport, "Resuming Schedule", true)) return false;
+    m_paused = false;
+    return true;
+}
+
+bool Scheduler::is_paused() { return m_paused; }
+
 bool Scheduler::add_event(Channel channel_, Time sleep_time, bool is_virtual_, unsigned char event_type) {
     unsigned int num_events = (unsigned int)m_events.size();
 
+    if (m_io_running) {
+        LOG(Error) << "Cannot add an event while the I/O thread is running.";
+        return false;
+    }
+
+    if (num_events >= MAX_SCHED_EVENTS) {
+        LOG(Error) << "Did not add event because the scheduler already has " << MAX_SCHED_EVENTS << " events.";
+        return false;
+    }
+
     if (m_enabled) {
         for (unsigned int i = 0; i < num_events; i++) {
             if (m_events[i].get_channel_num() == channel_.get_channel_num()) {
@@ -88,11 +152,35 @@ bool Scheduler::add_event(Channel channel_, Time sleep_time, bool is_virtual_, u
             }
         }
 
-        // add 5 us delay so that they don't all occur at the exact same time
-        auto delay_time = 5 * num_events;  // ms
+        // check that the updates of every event can still make it over the link each period
+        LinkBudget budget = compute_link_budget(m_transport->get_baud_rate(), m_duration, num_events + 1);
+        if (!budget.valid) {
+            LOG(Error) << "Did not add event because nothing can be sent in a " << m_duration << " ms schedule period at "
+                       << m_transport->get_baud_rate() << " baud.";
+            return false;
+        }
+        if (!budget.fits()) {
+            if (m_link_policy == LinkPolicy::Refuse) {
+                LOG(Error) << "Did not add event because only " << budget.events_per_tick << " event updates fit in the "
+                           << m_duration << " ms schedule period at " << m_transport->get_baud_rate() << " baud.";
+                return false;
+            }
+            if (m_link_policy == LinkPolicy::LowerRate) {
+                LOG(Warning) << "The updates of " << budget.events << " events do not fit in the " << m_duration
+                             << " ms schedule period. They will be sent every " << budget.rate_divider << " periods.";
+            } else {
+                LOG(Warning) << "The updates of " << budget.events << " events do not fit in the " << m_duration
+                             << " ms schedule period. Events will take turns, " << budget.events_per_tick
+                             << " updates per period.";
+            }
+        }
+        m_budget = budget;
+
+        // space the events out so that they don't all occur at the exact same time
+        auto delay_time = m_event_spacing * num_events;  // ms
 
         // add event to list of events
-        m_events.push_back(Event(m_hComm, m_id, delay_time, channel_, (unsigned char)(num_events + 1),is_virtual_));
+        m_events.push_back(Event(m_transport, m_id, delay_time, channel_, (unsigned char)(num_events + 1),is_virtual_));
 
         sleep(sleep_time);
 
@@ -105,16 +193,7 @@ bool Scheduler::add_event(Channel channel_, Time sleep_time, bool is_virtual_, u
 
 bool Scheduler::send_sync_msg() {
     if (m_enabled) {
-        std::vector<unsigned char> sync = {DEST_ADR,      // Destination
-                                           SRC_ADR,       // Source
-                                           SYNC_MSG,      // Msg type
-                                           SYNC_MSG_LEN,  // Message length
-                                           m_sync_char,   // sync character
-                                           0x00};         // Checksum placeholder
-
-        WriteMessage sync_message(sync);
-
-        if (sync_message.write(m_hComm, "Sending Sync Message")) {
+        if (m_sync_frame.write(*m_transport, "Sending Sync Message")) {
             return true;
         } else {
             disable();
@@ -127,24 +206,25 @@ bool Scheduler::send_sync_msg() {
 }
 
 void Scheduler::disable() {
+    // nothing was ever sent to a board, so there is nothing to tear down
+    if (m_transport == nullptr) return;
+
+    // wait for the I/O thread and drop the updates still waiting in the transport first, so that
+    // nothing reaches the board after the halt
+    stop_io_thread();
+    m_transport->discard_queued();
     halt_scheduler();
 
     m_enabled = false;
+    m_paused  = false;
 
     for (auto event = m_events.begin(); event != m_events.end(); event++) {
         event->delete_event();
     }
 
-    std::vector<unsigned char> del_sched = {DEST_ADR,             // Destination
-                                            SRC_ADR,              // Source
-                                            DELETE_SCHEDULE_MSG,  // Msg type
-                                            DEL_SCHED_LEN,        // Message length
-                                            m_id,                 // Schedule ID
-                                            0x00};                // Checksum placeholder
-
-    WriteMessage del_sched_message(del_sched);
+    m_del_sched_frame.write(*m_transport, "Closing Schedule", true);
 
-    del_sched_message.write(m_hComm, "Closing Schedule");
+    m_transport = nullptr;
 }
 
 void Scheduler::set_amp(Channel channel_, unsigned int amplitude_) {
@@ -153,7 +233,9 @@ void Scheduler::set_amp(Channel channel_, unsigned int amplitude_) {
         // if the event is for the correct channel we are looking for, write the amplitude and exit
         // the function
         if (event->get_channel_num() == channel_.get_channel_num()) {
+            if (amplitude_ == 0) m_stop_request = m_clock.get_elapsed_time().as_microseconds();
             event->set_amplitude(amplitude_);
+            if (m_io_running) post(event - m_events.begin());
             return;
         }
     }
@@ -182,6 +264,7 @@ void Scheduler::write_pw(Channel channel_, unsigned int pw_) {
         // exevent the function
         if (event->get_channel_num() == channel_.get_channel_num()) {
             event->set_pulsewidth(pw_);
+            if (m_io_running) post(event - m_events.begin());
             return;
         }
     }
@@ -204,25 +287,371 @@ unsigned int Scheduler::get_pw(Channel channel_) {
 }
 
 bool Scheduler::update() {
-    // loop over available events in the scheduler
+    // the I/O thread is already sending the updates
+    if (m_io_running) return !m_io_failed;
+
+    // events set to zero go out first, whatever state the link is in
+    size_t stop_count = 0;
+    if (!send_stops(false, stop_count)) return false;
+
+    // the link has not caught up with the previous update yet. Anything written now would be
+    // stale by the time it goes out, so the events keep their changes until the queue drains
+    if (link_backed_up()) {
+        m_update_count = stop_count;
+        return true;
+    }
+
+    // gather the messages of every event that changed since the last update
+    m_update_count = stop_count + collect_updates(false);
+
+    // nothing changed, so there is nothing to send
+    if (m_update_buffer.empty()) return true;
+
+    // send all of them with one write rather than one write per event
+    if (!m_transport->write(&m_update_buffer[0], m_update_buffer.size())) {
+        LOG(Error) << "Scheduler " << (int)m_id << " failed to update " << m_update_count << " events";
+        return false;
+    }
+    return true;
+}
+
+size_t Scheduler::get_update_count() { return m_update_count; }
+
+size_t Scheduler::collect_updates(bool from_mailbox_) {
+    // the buffer keeps its capacity between updates, so this does not allocate once warmed up
+    m_update_buffer.clear();
+
+    size_t num_events = m_events.size();
+    if (num_events == 0) return 0;
+
+    // when the updates do not fit on the link, either skip periods or take turns between events
+    size_t max_updates = num_events;
+    if (!m_budget.fits()) {
+        if (m_link_policy == LinkPolicy::LowerRate) {
+            if (m_tick++ % m_budget.rate_divider != 0) return 0;
+        } else if (m_link_policy == LinkPolicy::RoundRobin) {
+            max_updates = m_budget.events_per_tick > 0 ? m_budget.events_per_tick : 1;
+        }
+    }
+
+    // start after the last event looked at, so that events that did not get a turn go next
+    size_t update_count = 0;
+    size_t looked_at    = 0;
+    for (; looked_at < num_events && update_count < max_updates; looked_at++) {
+        size_t i = (m_next_event + looked_at) % num_events;
+        if (from_mailbox_) {
+            // anything posted twice since the last pass only sends its latest values
+            std::uint32_t slot = m_mailbox[i].exchange(0, std::memory_order_acquire);
+            if (slot & MAILBOX_FULL) {
+                unsigned int pw  = (slot >> MAILBOX_SHIFT) & MAILBOX_MASK;
+                unsigned int amp = slot & MAILBOX_MASK;
+                if (m_events[i].append_update(m_update_buffer, pw, amp)) update_count++;
+            }
+        } else {
+            if (m_events[i].append_update(m_update_buffer)) update_count++;
+        }
+    }
+    m_next_event = (m_next_event + looked_at) % num_events;
+
+    return update_count;
+}
+
+void Scheduler::set_link_policy(LinkPolicy link_policy_) { m_link_policy = link_policy_; }
+
+LinkPolicy Scheduler::get_link_policy() { return m_link_policy; }
+
+LinkBudget Scheduler::get_link_budget() { return m_budget; }
+
+void Scheduler::set_max_queued(size_t max_queued_) { m_max_queued = max_queued_; }
+
+size_t Scheduler::get_held_back_count() { return m_held_back_count; }
+
+Time Scheduler::get_stop_latency() { return microseconds(m_stop_latency); }
+
+bool Scheduler::send_stops(bool from_mailbox_, size_t& stop_count_) {
+    m_stop_buffer.clear();
+    stop_count_ = 0;
+
+    for (size_t i = 0; i < m_events.size(); i++) {
+        unsigned int pw;
+        if (from_mailbox_) {
+            std::uint32_t slot = m_mailbox[i].load(std::memory_order_acquire);
+            if (!(slot & MAILBOX_FULL) || (slot & MAILBOX_MASK) != 0) continue;
+            // if something was posted in the meantime, it is left for the routine pass
+            if (!m_mailbox[i].compare_exchange_strong(slot, 0, std::memory_order_acquire)) continue;
+            pw = (slot >> MAILBOX_SHIFT) & MAILBOX_MASK;
+        } else {
+            if (m_events[i].get_amplitude() != 0) continue;
+            pw = m_events[i].get_pulsewidth();
+        }
+        if (m_events[i].append_update(m_stop_buffer, pw, 0)) stop_count_++;
+    }
+
+    if (m_stop_buffer.empty()) return true;
+
+    if (!m_transport->write_priority(&m_stop_buffer[0], m_stop_buffer.size())) {
+        LOG(Error) << "Scheduler " << (int)m_id << " failed to stop " << stop_count_ << " events";
+        return false;
+    }
+    // only time the stop if it was requested, rather than being a pulsewidth change at zero
+    std::int64_t stop_request = m_stop_request.exchange(-1);
+    if (stop_request >= 0) record_stop(microseconds(stop_request));
+    return true;
+}
+
+void Scheduler::record_stop(Time stop_time_) {
+    // the stop is only done once the last byte has left the transmit queue of the link
+    Time queued = microseconds(m_transport->get_byte_time().as_microseconds() * (std::int64_t)m_transport->get_output_queue_depth());
+    m_stop_latency = (m_clock.get_elapsed_time() - stop_time_ + queued).as_microseconds();
+}
+
+bool Scheduler::link_backed_up() {
+    if (m_max_queued == 0) return false;
+    if (m_transport->get_pending_bytes() <= m_max_queued) return false;
+    m_held_back_count++;
+    return true;
+}
+
+bool Scheduler::set_delay_time(Channel channel_, unsigned int delay_time_) {
+    if (!m_enabled) {
+        LOG(Error) << "Scheduler is not yet enabled. Not moving the event on channel " << channel_.get_channel_name();
+        return false;
+    }
+    if (delay_time_ >= m_duration) {
+        LOG(Error) << "A delay of " << delay_time_ << " ms does not fit in the " << m_duration
+                   << " ms schedule period. Not moving the event on channel " << channel_.get_channel_name();
+        return false;
+    }
+    Event* moved = nullptr;
     for (auto event = m_events.begin(); event != m_events.end(); event++) {
-        // If any channel fails to update, return false after throwing an error
-        if (!event->update()) {
-            LOG(Error) << "Channel " << event->get_channel_name() << " failed to update";
+        if (event->get_channel_num() == channel_.get_channel_num()) {
+            moved = &*event;
+        } else if (event->get_delay_time() == delay_time_) {
+            LOG(Error) << "The event on channel " << event->get_channel_name() << " already starts " << delay_time_
+                       << " ms into the period. Not moving the event on channel " << channel_.get_channel_name();
+            return false;
+        }
+    }
+    if (moved == nullptr) {
+        LOG(Error) << "Did not find the correct event to move on channel " << channel_.get_channel_name() << ". Nothing has changed.";
+        return false;
+    }
+    return moved->change_delay_time(delay_time_);
+}
+
+unsigned int Scheduler::get_delay_time(Channel channel_) {
+    for (auto event = m_events.begin(); event != m_events.end(); event++) {
+        if (event->get_channel_num() == channel_.get_channel_num()) {
+            return event->get_delay_time();
+        }
+    }
+    LOG(Error) << "Did not find the correct event to pull from on channel " << channel_.get_channel_name() << ". Returning 0.";
+    return 0;
+}
+
+bool Scheduler::check_event_spacing(unsigned int spacing_) {
+    if (!m_enabled) {
+        LOG(Error) << "Scheduler is not yet enabled. Not changing the event spacing";
+        return false;
+    }
+    if (spacing_ == 0) {
+        LOG(Error) << "Events must be at least 1 ms apart. Not changing the event spacing";
+        return false;
+    }
+    // the last event must still start within the period
+    if (!m_events.empty() && spacing_ * (m_events.size() - 1) >= m_duration) {
+        LOG(Error) << m_events.size() << " events " << spacing_ << " ms apart do not fit in the " << m_duration
+                   << " ms schedule period. Not changing the event spacing";
+        return false;
+    }
+    return true;
+}
+
+bool Scheduler::set_event_spacing(unsigned int spacing_) {
+    if (!check_event_spacing(spacing_)) return false;
+
+    std::vector<unsigned int> delay_times(m_events.size());
+    for (size_t i = 0; i < m_events.size(); i++) delay_times[i] = spacing_ * (unsigned int)i;
+    return set_delay_times(delay_times, spacing_);
+}
+
+std::vector<unsigned int> Scheduler::get_delay_times() {
+    std::vector<unsigned int> delay_times(m_events.size());
+    for (size_t i = 0; i < m_events.size(); i++) delay_times[i] = m_events[i].get_delay_time();
+    return delay_times;
+}
+
+bool Scheduler::set_delay_times(const std::vector<unsigned int>& delay_times_, unsigned int spacing_) {
+    if (!m_enabled) {
+        LOG(Error) << "Scheduler is not yet enabled. Not moving the events";
+        return false;
+    }
+    if (delay_times_.size() != m_events.size()) {
+        LOG(Error) << "Got " << delay_times_.size() << " delay times for the " << m_events.size() << " events of scheduler "
+                   << (int)m_id << ". Not moving the events";
+        return false;
+    }
+    for (size_t i = 0; i < delay_times_.size(); i++) {
+        if (delay_times_[i] >= m_duration) {
+            LOG(Error) << "A delay of " << delay_times_[i] << " ms does not fit in the " << m_duration
+                       << " ms schedule period. Not moving the events";
             return false;
         }
     }
+
+    std::vector<unsigned int> old_delay_times = get_delay_times();
+    for (size_t i = 0; i < m_events.size(); i++) {
+        if (m_events[i].get_delay_time() == delay_times_[i]) continue;
+        if (m_events[i].change_delay_time(delay_times_[i])) continue;
+
+        LOG(Error) << "Scheduler " << (int)m_id << " failed to move the event on channel " << m_events[i].get_channel_name();
+        // put the events that did move back, so that the schedule is left as it was
+        for (size_t j = i; j-- > 0;) {
+            if (m_events[j].get_delay_time() != old_delay_times[j] && !m_events[j].change_delay_time(old_delay_times[j])) {
+                LOG(Error) << "Scheduler " << (int)m_id << " could not put the event on channel " << m_events[j].get_channel_name()
+                           << " back to " << old_delay_times[j] << " ms";
+            }
+        }
+        return false;
+    }
+    m_event_spacing = spacing_;
     return true;
 }
 
+unsigned int Scheduler::get_event_spacing() { return m_event_spacing; }
+
 size_t Scheduler::get_num_events() { return m_events.size(); }
 
-std::vector<Event> Scheduler::get_events() { return m_events; }
+std::vector<Event>& Scheduler::get_events() { return m_events; }
 
 unsigned char Scheduler::get_id() { return m_id; }
 
-void Scheduler::set_id(unsigned char sched_id_) { m_id = sched_id_; }
+void Scheduler::set_id(unsigned char sched_id_) {
+    m_id              = sched_id_;
+    m_halt_frame      = HaltFrame(m_id);
+    m_del_sched_frame = DeleteScheduleFrame(m_id);
+    m_pause_frame     = ChangeScheduleStateFrame(m_id, false);
+    m_resume_frame    = ChangeScheduleStateFrame(m_id, true);
+}
 
 bool Scheduler::is_enabled() { return m_enabled; }
+
+unsigned int Scheduler::get_duration() { return m_duration; }
+
+bool Scheduler::check_duration(unsigned int duration_) {
+    if (!m_enabled) {
+        LOG(Error) << "Scheduler is not yet enabled. Not changing the schedule duration";
+        return false;
+    }
+    if (duration_ == 0 || duration_ > 0xFFFF) {
+        LOG(Error) << "A schedule duration of " << duration_ << " ms can not be sent to the UECU.";
+        return false;
+    }
+    for (size_t i = 0; i < m_events.size(); i++) {
+        if (m_events[i].get_delay_time() >= duration_) {
+            LOG(Error) << "Event on channel " << m_events[i].get_channel_name() << " starts " << m_events[i].get_delay_time()
+                       << " ms into the period, which does not fit in a " << duration_ << " ms period.";
+            return false;
+        }
+    }
+
+    // check that the updates of every event still make it over the link at the new rate
+    LinkBudget budget = compute_link_budget(m_transport->get_baud_rate(), duration_, m_events.size());
+    if (!budget.valid) {
+        LOG(Error) << "Nothing can be sent at " << m_transport->get_baud_rate() << " baud. Not changing the duration.";
+        return false;
+    }
+    if (!budget.fits() && m_link_policy == LinkPolicy::Refuse) {
+        LOG(Error) << "Only " << budget.events_per_tick << " event updates fit in a " << duration_
+                   << " ms schedule period at " << m_transport->get_baud_rate() << " baud. Not changing the duration.";
+        return false;
+    }
+    return true;
+}
+
+bool Scheduler::set_duration(unsigned int duration_) {
+    if (!check_duration(duration_)) return false;
+    LinkBudget budget = compute_link_budget(m_transport->get_baud_rate(), duration_, m_events.size());
+
+    // the I/O thread paces itself on the period, so it is restarted at the new one
+    bool io_threaded = m_io_running;
+    if (io_threaded) stop_io_thread();
+
+    ChangeScheduleFrame change_sched_message(m_id, m_sync_char, duration_);
+    bool success = change_sched_message.write(*m_transport, "NONE");
+    if (success) {
+        m_duration = duration_;
+        m_budget   = budget;
+        m_tick     = 0;
+    } else {
+        LOG(Error) << "Scheduler " << (int)m_id << " failed to change its duration to " << duration_ << " ms";
+    }
+
+    if (io_threaded && !start_io_thread()) return false;
+    return success;
+}
+
+bool Scheduler::start_io_thread() {
+    if (!m_enabled) {
+        LOG(Error) << "Scheduler is not yet enabled. Not starting the I/O thread";
+        return false;
+    }
+    if (m_io_running) return true;
+
+    // post what the events currently hold so the first pass sends anything not yet written
+    for (size_t i = 0; i < m_events.size(); i++) post(i);
+
+    m_update_count = 0;
+    m_io_failed    = false;
+    m_io_running   = true;
+    m_io_thread  = std::thread(&Scheduler::io_loop, this);
+    return true;
+}
+
+void Scheduler::stop_io_thread() {
+    m_io_running = false;
+    if (m_io_thread.joinable()) m_io_thread.join();
+}
+
+bool Scheduler::is_io_threaded() { return m_io_running; }
+
+bool Scheduler::io_failed() { return m_io_failed; }
+
+void Scheduler::post(size_t event_index_) {
+    std::uint32_t pw  = m_events[event_index_].get_pulsewidth() & MAILBOX_MASK;
+    std::uint32_t amp = m_events[event_index_].get_amplitude() & MAILBOX_MASK;
+    m_mailbox[event_index_].store(MAILBOX_FULL | (pw << MAILBOX_SHIFT) | amp, std::memory_order_release);
+}
+
+void Scheduler::io_loop() {
+    // there is no point in sending updates faster than the board can apply them
+    Timer io_timer(milliseconds(m_duration), Timer::WaitMode::Hybrid);
+
+    while (m_io_running) {
+        size_t stop_count = 0;
+        if (!send_stops(true, stop_count)) m_io_failed = true;
+        m_update_count += stop_count;
+
+        // leave the mailbox alone while the link is backed up, so that later posts overwrite the
+        // values that would have been stale by the time they went out
+        if (link_backed_up()) {
+            io_timer.wait();
+            continue;
+        }
+
+        // take whatever was posted since the last pass
+        size_t update_count = collect_updates(true);
+        m_update_count += update_count;
+
+        if (!m_update_buffer.empty()) {
+            if (!m_transport->write(&m_update_buffer[0], m_update_buffer.size())) {
+                LOG(Error) << "Scheduler " << (int)m_id << " failed to update " << update_count << " events";
+                m_io_failed = true;
+            }
+        }
+
+        io_timer.wait();
+    }
+}
 }  // namespace fes
 }  // namespace mahi
@@ -14,15 +14,10 @@
 //
 // Author(s): Nathan Dunkelberger (nbd2@rice.edu)
 
-#include <Windows.h>
-#include <tchar.h>
-
 #include <Mahi/Fes/Core/Event.hpp>
 #include <Mahi/Fes/Core/Stimulator.hpp>
 #include <Mahi/Fes/Utility/Communication.hpp>
 #include <Mahi/Util.hpp>
-#include <codecvt>
-#include <locale>
 #include <mutex>
 #include <string>
 
@@ -31,12 +26,21 @@ using namespace mahi::util;
 namespace mahi {
 namespace fes {
 
-Stimulator::Stimulator(const std::string& name_, std::vector<Channel>& channels_,  const std::string& com_port_1_, const std::string& com_port_2_, bool is_virtual_) :
+Stimulator::Stimulator(const std::string& name_, std::vector<Channel>& channels_,  const std::string& com_port_1_, const std::string& com_port_2_, bool is_virtual_, const std::string& capture_file_) :
+    Stimulator(name_, channels_, std::vector<std::unique_ptr<Transport>>(), is_virtual_) {
+    m_transports.push_back(make_serial_transport(com_port_1_));
+    if (com_port_2_.compare("NONE") != 0){
+        m_transports.push_back(make_serial_transport(com_port_2_));
+    }
+    m_num_ports = m_transports.size();
+
+    if (capture_file_.compare("NONE") != 0) start_capture(capture_file_);
+    enable();
+}
+
+Stimulator::Stimulator(const std::string& name_, std::vector<Channel>& channels_, std::vector<std::unique_ptr<Transport>> transports_, bool is_virtual_, const std::string& capture_file_) :
     m_name(name_),
-    m_com_port_1(com_port_1_),
-    m_com_port_2(com_port_2_),
-    m_com_ports({m_com_port_1, m_com_port_2}),
-    m_hComms({&m_hComm_1, &m_hComm_2}),
+    m_transports(std::move(transports_)),
     m_enabled(false),
     m_is_virtual(is_virtual_),
     m_channels(channels_),
@@ -47,32 +51,68 @@ Stimulator::Stimulator(const std::string& name_, std::vector<Channel>& channels_
     amplitudes(num_events, 0),
     pulsewidths(num_events, 0),
     max_amplitudes(num_events, 0),
-    max_pulsewidths(num_events, 0) {
+    max_pulsewidths(num_events, 0),
+    m_fire_cancel(false) {
     for (auto i = 0; i < num_events; i++) {
         max_amplitudes[i]  = m_channels[i].get_max_amplitude();
         max_pulsewidths[i] = m_channels[i].get_max_pulse_width();
         channel_names.push_back(m_channels[i].get_channel_name());
     }
-    if (m_com_port_2.compare("NONE") != 0){
-        m_num_ports = 2;
+    if (m_transports.size() > m_schedulers.size()) {
+        LOG(Error) << "A stimulator can handle at most " << m_schedulers.size() << " boards. Ignoring the extra transports.";
+        m_transports.resize(m_schedulers.size());
+    }
+    m_num_ports = m_transports.size();
+
+    m_dispatcher.on_error_report([this](const ErrorReport& report_) {
+        LOG(Error) << "A board reported error " << (int)report_.error << " for a message of type " << (int)report_.msg_type << ".";
+        m_board_error = true;
+        if (m_on_error_report) m_on_error_report(report_);
+    });
+    m_dispatcher.on_event_error([this](const EventErrorReport& report_) {
+        LOG(Error) << "A board reported error " << (int)report_.error << " for event " << (int)report_.event_id
+                   << " on channel " << (int)report_.channel << ".";
+        m_board_error = true;
+        if (m_on_event_error) m_on_event_error(report_);
+    });
+
+    // the reply carries no event id, so it answers the oldest pulse still waiting on the same
+    // channel of the board it came from
+    m_dispatcher.on_event_command([this](const EventCommandReply& reply_) {
+        {
+            std::lock_guard<std::mutex> lock(m_fire_mtx);
+            auto pulse = m_fire_pending.begin();
+            while (pulse != m_fire_pending.end() && (pulse->board != m_reply_board || pulse->channel != reply_.channel)) pulse++;
+            if (pulse == m_fire_pending.end()) {
+                m_fire_stats.unmatched++;
+                LOG(Warning) << "Board " << m_reply_board + 1 << " replied to an event command on channel " << (int)reply_.channel << " that was not fired.";
+            } else {
+                m_fire_pending.erase(pulse);
+                m_fire_stats.replies++;
+            }
+        }
+        if (m_on_event_command) m_on_event_command(reply_);
+    });
+
+    // the com port constructor creates its transports first, and captures and enables once they
+    // exist
+    if (m_num_ports > 0) {
+        if (capture_file_.compare("NONE") != 0) start_capture(capture_file_);
+        enable();
     }
-    
-    enable();
 }
 
-Stimulator::~Stimulator() { disable(); }
+Stimulator::~Stimulator() {
+    disable();
+    stop_capture();
+}
 
 // Open and configure serial port, and initialize the channels on the board.
 bool Stimulator::enable() {
-    // open the comport with read/write permissions
+    // open and configure the transport to each board
     for (size_t i = 0; i < m_num_ports; i++)
     {
-        if (!open_port(m_hComms[i], m_com_ports[i])) {
-            disable();
-            return m_enabled;
-        }
-        // Configure the parameters for serial port ttyUSB0
-        if (!configure_port(m_hComms[i])) {
+        if (!m_transports[i]->open()) {
             disable();
             return m_enabled;
         }
@@ -87,6 +127,13 @@ bool Stimulator::enable() {
 }
 
 void Stimulator::disable() {
+    // drop what is left of a burst, so that no pulse goes out after the halt
+    if (m_fire_worker) {
+        m_fire_cancel = true;
+        m_fire_worker->wait();
+        m_fire_cancel = false;
+    }
+
     if (is_enabled()) {
         for (size_t i = 0; i < m_num_ports; i++){
             m_schedulers[i]->disable();
@@ -99,99 +146,15 @@ void Stimulator::disable() {
     m_enabled = false;
 }
 
-bool Stimulator::open_port(HANDLE* hComm, std::string com_port) {
-    // the comport must be formatted as an LPCWSTR, so we need to get it into that form from a
-    // std::string
-    std::wstring com_prefix = L"\\\\.\\";
-    std::wstring com_suffix =
-        std::wstring_convert<std::codecvt_utf8<wchar_t>>().from_bytes(com_port);
-    std::wstring comID = com_prefix + com_suffix;
-
-    // std::wstring stemp = std::wstring(com_port_formatted.begin(), com_port_formatted.end());
-    // LPCWSTR com_port_lpcwstr = stemp.c_str();
-
-    *hComm = CreateFileW(comID.c_str(),                 // port name
-                        GENERIC_READ | GENERIC_WRITE,  // Read/Write
-                        0,                             // No Sharing
-                        NULL,                          // No Security
-                        OPEN_EXISTING,                 // Open existing port only
-                        0,                             // Non Overlapped I/O
-                        NULL);                         // Null for Comm Devices
-
-    // Check if creating the comport was successful or not and log it
-    if (*hComm == INVALID_HANDLE_VALUE) {
-        LOG(Error) << "Failed to open port " << com_port;
-        return false;
-    } else {
-        LOG(Info) << "Successfully opened port " << com_port;
-    }
-
-    return true;
-}
-
-bool Stimulator::configure_port(HANDLE* hComm) {  // configure_port establishes the settings for each serial port
-
-    // http://bd.eduweb.hhs.nl/micprg/pdf/serial-win.pdf
-
-    m_dcbSerialParams.DCBlength = sizeof(DCB);
-
-    if (!GetCommState(*hComm, &m_dcbSerialParams)) {
-        LOG(Error) << "Error getting serial port state";
-        return false;
-    }
-
-    // set parameters to use for serial communication
-
-    // set the baud rate that we will communicate at to 9600
-    m_dcbSerialParams.BaudRate = CBR_9600;
-
-    // 8 bits in the bytes transmitted and received.
-    m_dcbSerialParams.ByteSize = 8;
-
-    // Specify that we are using one stop bit
-    m_dcbSerialParams.StopBits = ONESTOPBIT;
-
-    // Specify that we are using no parity
-    m_dcbSerialParams.Parity = NOPARITY;
-
-    // Disable all parameters dealing with flow control
-    m_dcbSerialParams.fOutX       = FALSE;
-    m_dcbSerialParams.fInX        = FALSE;
-    m_dcbSerialParams.fRtsControl = RTS_CONTROL_DISABLE;
-    m_dcbSerialParams.fDtrControl = DTR_CONTROL_DISABLE;
-    // dcbSerialParams.fOutxCtsFlow = FALSE;
-    // dcbSerialParams.fOutxDsrFlow = FALSE;
-
-    // Set communication parameters for the serial port
-    if (!SetCommState(*hComm, &m_dcbSerialParams)) {
-        LOG(Error) << "Error setting serial port state";
-        return false;
-    }
-
-    COMMTIMEOUTS timeouts                = {0};
-    timeouts.ReadIntervalTimeout         = 10;
-    timeouts.ReadTotalTimeoutConstant    = 10;
-    timeouts.ReadTotalTimeoutMultiplier  = 10;
-    timeouts.WriteTotalTimeoutConstant   = 50;
-    timeouts.WriteTotalTimeoutMultiplier = 10;
-    if (!SetCommTimeouts(*hComm, &timeouts)) {
-        LOG(Error) << "Error setting serial port timeouts";
-        return false;
-    }
-
-    PurgeComm(*hComm,PURGE_TXABORT);
-    PurgeComm(*hComm,PURGE_RXABORT);
-    PurgeComm(*hComm,PURGE_RXCLEAR);
-	PurgeComm(*hComm,PURGE_TXCLEAR);
-
-    return true;
-}
-
 bool Stimulator::initialize_board() {
     // delay time after sending setup messages of serial comm
 
     for (auto i = 0; i < m_channels.size(); i++) {
-        if (!m_channels[i].setup_channel(*m_hComms[m_channels[i].get_board_num()], m_delay_time)) {
+        if (m_channels[i].get_board_num() >= m_num_ports) {
+            LOG(Error) << "Channel " << m_channels[i].get_channel_name() << " is on a board that has no port.";
+            return false;
+        }
+        if (!m_channels[i].setup_channel(*m_transports[m_channels[i].get_board_num()], m_delay_time)) {
             return false;
         };
     }
@@ -202,19 +165,38 @@ bool Stimulator::initialize_board() {
 }
 
 bool Stimulator::halt_scheduler() { 
-    bool success = true;
-    for (size_t i = 0; i < m_num_ports; i++)
-    {
-        if(!m_schedulers[i]->halt_scheduler()){
-            success = false;
-        }
+    return for_each_port([this](size_t i) { return m_schedulers[i]->halt_scheduler(); });
+}
+
+bool Stimulator::pause() {
+    if (!is_enabled()) {
+        LOG(Error) << "Stimulator has not yet been enabled. Nothing to pause";
+        return false;
     }
-    return success;
+    return for_each_port([this](size_t i) { return m_schedulers[i]->pause(); });
+}
+
+bool Stimulator::resume() {
+    if (!is_enabled()) {
+        LOG(Error) << "Stimulator has not yet been enabled. Nothing to resume";
+        return false;
+    }
+    // send the resumes together so that both boards start again at the same time
+    return for_each_port([this](size_t i) { return m_schedulers[i]->resume(); });
+}
+
+bool Stimulator::is_paused() {
+    for (size_t i = 0; i < m_num_ports; i++) {
+        if (m_schedulers[i]->is_paused()) return true;
+    }
+    return false;
 }
 
 void Stimulator::close_stimulator() {
+    stop_readers();
+
     for (size_t i = 0; i < m_num_ports; i++){
-        CloseHandle(*m_hComms[i]);
+        m_transports[i]->close();
     }
     
     m_enabled = false;
@@ -223,12 +205,10 @@ void Stimulator::close_stimulator() {
 bool Stimulator::begin() {
     if (is_enabled()) {
         m_enabled = true;
-        bool success = true;
-        for (size_t i = 0; i < m_num_ports; i++)
-        {
-            if(!m_schedulers[i]->send_sync_msg()){
-                success = false;
-            }
+        bool success = start_readers();
+        // send the sync messages together so that both boards start at the same time
+        if (!for_each_port([this](size_t i) { return m_schedulers[i]->send_sync_msg(); })) {
+            success = false;
         }
         return success;
     } else {
@@ -295,31 +275,46 @@ bool Stimulator::update() {
             std::lock_guard<std::mutex> lock(m_mtx);
             for (size_t j = 0; j < m_num_ports; j++)
             {
-                for (size_t i = 0; i < m_schedulers[j]->get_num_events(); i++) {
-                    Channel channel_ = m_schedulers[j]->get_events()[i].get_channel();
-                    
-                    amplitudes[channel_.get_channel_num()]      = m_schedulers[j]->get_amp(channel_);
-                    pulsewidths[channel_.get_channel_num()]     = m_schedulers[j]->get_pw(channel_);
-                    max_amplitudes[channel_.get_channel_num()]  = channel_.get_max_amplitude();
-                    max_pulsewidths[channel_.get_channel_num()] = channel_.get_max_pulse_width();
+                // read straight from the events rather than copying their channels, so that
+                // updating never allocates
+                for (auto& event : m_schedulers[j]->get_events()) {
+                    unsigned char channel_num = event.get_channel_num();
+
+                    amplitudes[channel_num]      = event.get_amplitude();
+                    pulsewidths[channel_num]     = event.get_pulsewidth();
+                    max_amplitudes[channel_num]  = event.get_max_amplitude();
+                    max_pulsewidths[channel_num] = event.get_max_pulsewidth();
                 }
             }
         }
-        bool success = true;
-        for (size_t i = 0; i < m_num_ports; i++)
-        {
-            if(!m_schedulers[i]->update()){
-                success = false;
-            }
+        if (is_io_threaded()) return check_io_threads();
+
+        // snapshot the transport counters so that the traffic of this update can be reported
+        m_stats_before.resize(m_num_ports);
+        m_held_before.resize(m_num_ports);
+        for (size_t i = 0; i < m_num_ports; i++) {
+            m_stats_before[i] = m_transports[i]->get_stats();
+            m_held_before[i]  = m_schedulers[i]->get_held_back_count();
         }
-        std::vector<ReadMessage> incoming_messages = get_all_messages(m_hComms,m_num_ports);
-        for (size_t i = 0; i < incoming_messages.size(); i++){
-            if (!incoming_messages[i].is_valid()){
-                LOG(Error) << "Return message (below) either invalid or an error. Disabling stimulator.";
-                print_message(incoming_messages[i].get_message());
-                success = false;
-            }
+
+        // write to each board at the same time rather than one after the other
+        bool success = for_each_port([this](size_t i) { return m_schedulers[i]->update(); });
+        UpdateStats update_stats;
+        for (size_t i = 0; i < m_num_ports; i++) {
+            update_stats.messages += m_schedulers[i]->get_update_count();
+            update_stats.held_back += m_schedulers[i]->get_held_back_count() - m_held_before[i];
+        }
+        if (!check_replies()) success = false;
+
+        for (size_t i = 0; i < m_num_ports; i++) {
+            TransportStats stats_after = m_transports[i]->get_stats();
+            update_stats.bytes_written += stats_after.bytes_written - m_stats_before[i].bytes_written;
+            update_stats.bytes_read    += stats_after.bytes_read - m_stats_before[i].bytes_read;
+            update_stats.write_calls   += stats_after.write_calls - m_stats_before[i].write_calls;
+            update_stats.read_calls    += stats_after.read_calls - m_stats_before[i].read_calls;
         }
+        m_update_stats = update_stats;
+
         if (!success) disable();
         return success;
     } else {
@@ -335,24 +330,63 @@ bool Stimulator::create_scheduler(const unsigned char sync_msg, double frequency
     } else {
         duration = 50;
     }
+    if (duration == 0 || duration > 0xFFFF) {
+        LOG(Error) << "A frequency of " << frequency_ << " Hz gives a schedule duration of " << duration
+                   << " ms, which can not be sent to the UECU. Not creating scheduler";
+        return false;
+    }
 
     if (is_enabled()) {
-        bool success = false;
-        for (size_t i = 0; i < m_num_ports; i++){
-            bool success = m_schedulers[i]->create_scheduler(*m_hComms[i], sync_msg, duration, m_delay_time);
+        // check what the channels of each board would need from its link in the worst case
+        for (size_t i = 0; i < m_num_ports; i++) {
+            size_t board_channels = 0;
+            for (size_t j = 0; j < m_channels.size(); j++) {
+                if (m_channels[j].get_board_num() == i) board_channels++;
+            }
+            LinkBudget budget = compute_link_budget(m_transports[i]->get_baud_rate(), duration, board_channels);
+            if (!budget.valid) {
+                LOG(Error) << "Nothing can be sent to board " << i + 1 << " at " << m_transports[i]->get_baud_rate()
+                           << " baud. Not creating scheduler";
+                return false;
+            }
+            LOG(Info) << "Board " << i + 1 << ": " << board_channels << " channels need " << budget.wire_time.as_milliseconds()
+                      << " ms of the " << duration << " ms period (" << (int)(budget.headroom * 100) << "% headroom).";
+            if (!budget.fits() && m_schedulers[i]->get_link_policy() == LinkPolicy::Refuse) {
+                LOG(Error) << "Only " << budget.events_per_tick << " of the " << board_channels << " channels on board "
+                           << i + 1 << " can be updated every period. Not creating scheduler";
+                return false;
+            }
+        }
+
+        // the reply is read here, so the readers must not take it
+        bool readers_running = stop_readers();
+
+        // create the scheduler on each board at the same time, since each one waits for the board
+        bool success = for_each_port([this, sync_msg, duration](size_t i) {
+            if (!m_schedulers[i]->create_scheduler(*m_transports[i], sync_msg, duration, m_delay_time)) {
+                return false;
+            }
             if (!m_is_virtual){
-                ReadMessage scheduler_created_msg(read_message(*m_hComms[i], true));
-                if (scheduler_created_msg.is_valid()){
-                    m_schedulers[i]->set_id(scheduler_created_msg.get_data()[0]);
+                Reply                reply_buffer;
+                ReadMessageView      scheduler_created_msg = read_message(*m_transports[i], reply_buffer, true);
+                ScheduleCreatedReply scheduler_created;
+                if (scheduler_created_msg.is_valid() && decode_reply(scheduler_created_msg, scheduler_created)){
+                    m_schedulers[i]->set_id(scheduler_created.schedule_id);
                 }
                 else{
-                    LOG(Error) << "Scheduler created return message (below) was either invalid or an error. Disabling stimulator.";
+                    LOG(Error) << "Scheduler created return message (below) was either invalid or an error.";
                     print_message(scheduler_created_msg.get_message());
-                    disable();
                     return false;
                 }
             }
+            return true;
+        });
+        if (!success) {
+            LOG(Error) << "Could not create the schedulers. Disabling stimulator.";
+            disable();
+            return false;
         }
+        if (readers_running) start_readers();
         return success;
     } else {
         LOG(Error) << "Stimulator has not yet been enabled. Not creating scheduler";
@@ -360,9 +394,91 @@ bool Stimulator::create_scheduler(const unsigned char sync_msg, double frequency
     }
 }
 
+bool Stimulator::set_frequency(double frequency_) {
+    if (!is_enabled()) {
+        LOG(Error) << "Stimulator has not yet been enabled. Not changing the frequency";
+        return false;
+    }
+    if (frequency_ <= 0) {
+        LOG(Error) << "Frequency must be above 0 Hz. Not changing the frequency";
+        return false;
+    }
+    unsigned int duration = (unsigned int)(1.0 / frequency_ * 1000);
+
+    // check every board before changing any, so that the boards do not end up at different rates
+    std::vector<unsigned int> old_durations(m_num_ports);
+    for (size_t i = 0; i < m_num_ports; i++) {
+        if (!m_schedulers[i]->check_duration(duration)) {
+            LOG(Error) << "Board " << i + 1 << " can not run at " << frequency_ << " Hz. Not changing the frequency";
+            return false;
+        }
+        old_durations[i] = m_schedulers[i]->get_duration();
+    }
+
+    // change every board at the same time. Each task only writes its own element
+    std::vector<char> changed(m_num_ports, 0);
+    if (for_each_port([this, duration, &changed](size_t i) { return (changed[i] = m_schedulers[i]->set_duration(duration)) != 0; })) {
+        return true;
+    }
+
+    // put the boards that did change back, so that they all stay at the old rate
+    for (size_t i = 0; i < m_num_ports; i++) {
+        if (changed[i] && !m_schedulers[i]->set_duration(old_durations[i])) {
+            LOG(Error) << "Board " << i + 1 << " could not be put back to a " << old_durations[i] << " ms period";
+        }
+    }
+    LOG(Error) << "Could not change the frequency to " << frequency_ << " Hz";
+    return false;
+}
+
+bool Stimulator::set_delay_time(Channel channel_, unsigned int delay_time_) {
+    if (!is_enabled()) {
+        LOG(Error) << "Stimulator has not yet been enabled. Not moving the event";
+        return false;
+    }
+    return m_schedulers[channel_.get_board_num()]->set_delay_time(channel_, delay_time_);
+}
+
+bool Stimulator::set_event_spacing(unsigned int spacing_) {
+    if (!is_enabled()) {
+        LOG(Error) << "Stimulator has not yet been enabled. Not changing the event spacing";
+        return false;
+    }
+
+    // check every board before changing any, so that a board is not left moved on its own
+    std::vector<std::vector<unsigned int>> old_delay_times(m_num_ports);
+    std::vector<unsigned int>              old_spacings(m_num_ports);
+    for (size_t i = 0; i < m_num_ports; i++) {
+        if (!m_schedulers[i]->check_event_spacing(spacing_)) {
+            LOG(Error) << "Board " << i + 1 << " can not space its events " << spacing_ << " ms apart. Not changing the event spacing";
+            return false;
+        }
+        old_delay_times[i] = m_schedulers[i]->get_delay_times();
+        old_spacings[i]    = m_schedulers[i]->get_event_spacing();
+    }
+
+    // change every board at the same time. Each task only writes its own element
+    std::vector<char> changed(m_num_ports, 0);
+    if (for_each_port([this, spacing_, &changed](size_t i) { return (changed[i] = m_schedulers[i]->set_event_spacing(spacing_)) != 0; })) {
+        return true;
+    }
+
+    // put the events of the boards that did change back where they were
+    for (size_t i = 0; i < m_num_ports; i++) {
+        if (changed[i] && !m_schedulers[i]->set_delay_times(old_delay_times[i], old_spacings[i])) {
+            LOG(Error) << "Board " << i + 1 << " could not put its events back";
+        }
+    }
+    LOG(Error) << "Could not space the events " << spacing_ << " ms apart";
+    return false;
+}
+
 bool Stimulator::add_event(Channel channel_, unsigned char event_type) {
     if (is_enabled()) {
-        bool success = m_schedulers[channel_.get_board_num()]->add_event(channel_, m_delay_time, event_type);
+        // the reply is read by the event, so the readers must not take it
+        bool readers_running = stop_readers();
+        bool success = m_schedulers[channel_.get_board_num()]->add_event(channel_, m_delay_time, m_is_virtual, event_type);
+        if (readers_running) start_readers();
         return success;
     } else {
         LOG(Error) << "Stimulator has not yet been enabled. Not adding event to scheduler";
@@ -391,30 +507,318 @@ bool Stimulator::is_enabled() { return m_enabled; }
 
 std::string Stimulator::get_name() { return m_name; }
 
-// void Stimulator::read_all() {
-//     DWORD         msg_size = 1;
-//     unsigned char msg[1];
-//     bool          done       = false;
-//     bool          first_pass = true;
-
-//     DWORD dwBytesRead = 0;
-//     while (!done) {
-//         if (!ReadFile(m_hComm, msg, msg_size, &dwBytesRead, NULL)) {
-//             LOG(Error) << "Could not read message";
-//         }
-//         if (dwBytesRead != 0) {
-//             if (first_pass) {
-//                 std::cout << "Message: ";
-//                 first_pass = false;
-//             }
-//             char char_buff[20];
-//             sprintf(char_buff, "0x%02X", (unsigned int)msg[0]);
-//             std::cout << char_buff << ", ";
-//         } else {
-//             std::cout << std::endl;
-//             done = true;
-//         }
-//     }
-// }
+Transport* Stimulator::get_transport(size_t board_num_) {
+    return board_num_ < m_num_ports ? m_transports[board_num_].get() : nullptr;
+}
+
+UpdateStats Stimulator::get_update_stats() { return m_update_stats; }
+
+void Stimulator::set_link_policy(LinkPolicy link_policy_) {
+    for (size_t i = 0; i < m_schedulers.size(); i++) {
+        m_schedulers[i]->set_link_policy(link_policy_);
+    }
+}
+
+void Stimulator::set_max_queued(size_t max_queued_) {
+    for (size_t i = 0; i < m_schedulers.size(); i++) {
+        m_schedulers[i]->set_max_queued(max_queued_);
+    }
+}
+
+Time Stimulator::get_stop_latency() {
+    Time stop_latency = Time::Zero;
+    for (size_t i = 0; i < m_num_ports; i++) {
+        if (m_schedulers[i]->get_stop_latency() > stop_latency) stop_latency = m_schedulers[i]->get_stop_latency();
+    }
+    return stop_latency;
+}
+
+bool Stimulator::start_capture(const std::string& filename_) {
+    if (is_io_threaded()) {
+        LOG(Error) << "Stop the I/O threads before starting a capture";
+        return false;
+    }
+    stop_capture();
+    if (!m_capture.open(filename_)) return false;
+
+    // the readers call the tap, so they can't be running while it is swapped
+    bool readers_running = stop_readers();
+    for (size_t i = 0; i < m_num_ports; i++) m_capture.attach(*m_transports[i], (unsigned char)i);
+    if (readers_running) start_readers();
+    return true;
+}
+
+void Stimulator::stop_capture() {
+    if (!m_capture.is_open()) return;
+    if (is_io_threaded()) {
+        LOG(Error) << "Stop the I/O threads before stopping the capture";
+        return;
+    }
+
+    bool readers_running = stop_readers();
+    for (size_t i = 0; i < m_num_ports; i++) m_transports[i]->set_tap(nullptr);
+    if (readers_running) start_readers();
+    m_capture.close();
+}
+
+CaptureStats Stimulator::get_capture_stats() { return m_capture.get_stats(); }
+
+bool Stimulator::fire(Channel channel_, unsigned int pw_, unsigned int amp_, unsigned int count_, Time spacing_) {
+    // the pulses are timed from the trigger, so nothing below counts against the latency
+    Time trigger_time = m_fire_clock.get_elapsed_time();
+
+    if (!is_enabled()) {
+        LOG(Error) << "Stimulator has not yet been enabled. Not firing";
+        return false;
+    }
+    if (channel_.get_board_num() >= m_num_ports) {
+        LOG(Error) << "There is no board " << (int)channel_.get_board_num() << " for channel " << channel_.get_channel_name() << ". Not firing";
+        return false;
+    }
+    // the limits are those the board was set up with, which update_max_amp etc. keep in m_channels
+    auto channel = m_channels.begin();
+    while (channel != m_channels.end() && channel->get_channel_num() != channel_.get_channel_num()) channel++;
+    if (channel == m_channels.end()) {
+        LOG(Error) << "Channel " << channel_.get_channel_name() << " was not set up on the stimulator. Not firing";
+        return false;
+    }
+    if (amp_ > channel->get_max_amplitude()) {
+        amp_ = channel->get_max_amplitude();
+        LOG(Warning) << "Commanded too high of a amplitude on " << channel->get_channel_name() << " channel. It was clamped to " << amp_ << ".";
+    }
+    if (pw_ > channel->get_max_pulse_width()) {
+        pw_ = channel->get_max_pulse_width();
+        LOG(Warning) << "Commanded too high of a pulsewidth on " << channel->get_channel_name() << " channel. It was clamped to " << pw_ << ".";
+    }
+
+    if (m_fire_worker && !m_fire_worker->is_done()) {
+        LOG(Error) << "The last burst is still being fired. Not firing on channel " << channel->get_channel_name();
+        return false;
+    }
+
+    size_t                board         = channel_.get_board_num();
+    unsigned char         board_channel = channel_.get_board_channel_num();
+    StimEventCommandFrame pulse(0x00, board_channel, (unsigned char)pw_, (unsigned char)amp_, 0x00);
+    if (!send_pulse(board, board_channel, pulse, trigger_time)) {
+        LOG(Error) << "Failed to fire on channel " << channel->get_channel_name();
+        return false;
+    }
+    if (count_ < 2) return true;
+
+    // the rest of the burst is timed on the fire worker, so the caller is not held up
+    if (!m_fire_worker) m_fire_worker.reset(new PortWorker());
+    std::string name = channel->get_channel_name();
+    m_fire_worker->submit([this, board, board_channel, pulse, name, count_, spacing_, trigger_time] {
+        for (unsigned int i = 1; i < count_ && !m_fire_cancel; i++) {
+            Time due  = trigger_time + microseconds(spacing_.as_microseconds() * i);
+            Time wait = due - m_fire_clock.get_elapsed_time();
+            if (wait > Time::Zero) sleep(wait);
+            if (m_fire_cancel) break;
+
+            if (!send_pulse(board, board_channel, pulse, due)) {
+                LOG(Error) << "Failed to fire pulse " << i + 1 << " of " << count_ << " on channel " << name;
+                return false;
+            }
+        }
+        return true;
+    });
+    return true;
+}
+
+bool Stimulator::send_pulse(size_t board_, unsigned char channel_, const StimEventCommandFrame& pulse_, Time due_) {
+    Transport& transport = *m_transports[board_];
+    if (!pulse_.write(transport, "NONE", true)) return false;
+
+    // the pulse is only on its way once the last byte has left the transmit queue of the link. The
+    // queue is not watched until it drains, so this is an estimate
+    Time                        queued = microseconds(transport.get_byte_time().as_microseconds() * (std::int64_t)transport.get_output_queue_depth());
+    Time                        sent   = m_fire_clock.get_elapsed_time();
+    std::lock_guard<std::mutex> lock(m_fire_mtx);
+    m_fire_stats.commands++;
+    m_fire_stats.est_latency = sent - due_ + queued;
+    if (m_fire_stats.est_latency > m_fire_stats.max_est_latency) m_fire_stats.max_est_latency = m_fire_stats.est_latency;
+    m_fire_pending.push_back({board_, channel_, sent});
+    return true;
+}
+
+FireStats Stimulator::get_fire_stats() {
+    std::lock_guard<std::mutex> lock(m_fire_mtx);
+    return m_fire_stats;
+}
+
+void Stimulator::set_fire_reply_timeout(Time timeout_) {
+    std::lock_guard<std::mutex> lock(m_fire_mtx);
+    m_fire_reply_timeout = timeout_;
+}
+
+void Stimulator::set_on_event_command(ReplyDispatcher::EventCommandCallback on_event_command_) { m_on_event_command = on_event_command_; }
+
+void Stimulator::set_on_error_report(ReplyDispatcher::ErrorReportCallback on_error_report_) { m_on_error_report = on_error_report_; }
+
+void Stimulator::set_on_event_error(ReplyDispatcher::EventErrorCallback on_event_error_) { m_on_event_error = on_event_error_; }
+
+LinkBudget Stimulator::get_link_budget(size_t board_num_) {
+    if (board_num_ >= m_num_ports) {
+        LOG(Error) << "There is no board " << board_num_ << ". Returning an empty link budget.";
+        return LinkBudget();
+    }
+    return m_schedulers[board_num_]->get_link_budget();
+}
+
+bool Stimulator::for_each_port(const std::function<bool(size_t)>& task_) {
+    // the first board is handled on this thread, and every other board by its own worker
+    for (size_t i = m_workers.size() + 1; i < m_num_ports; i++) {
+        m_workers.push_back(std::unique_ptr<PortWorker>(new PortWorker()));
+    }
+    for (size_t i = 1; i < m_num_ports; i++) {
+        m_workers[i - 1]->submit([&task_, i] { return task_(i); });
+    }
+    bool success = m_num_ports > 0 ? task_(0) : true;
+    for (size_t i = 1; i < m_num_ports; i++) {
+        if (!m_workers[i - 1]->wait()) success = false;
+    }
+    return success;
+}
+
+bool Stimulator::start_io_threads() {
+    if (!is_enabled()) {
+        LOG(Error) << "Stimulator has not yet been enabled. Not starting the I/O threads";
+        return false;
+    }
+    if (!start_readers()) return false;
+
+    m_io_stats.resize(m_num_ports);
+    m_io_counts.assign(m_num_ports, 0);
+    m_held_counts.resize(m_num_ports);
+    for (size_t i = 0; i < m_num_ports; i++) {
+        m_io_stats[i]    = m_transports[i]->get_stats();
+        m_held_counts[i] = m_schedulers[i]->get_held_back_count();
+        if (!m_schedulers[i]->start_io_thread()) {
+            stop_io_threads();
+            return false;
+        }
+    }
+    LOG(Info) << "Started " << m_num_ports << " I/O threads";
+    return true;
+}
+
+void Stimulator::stop_io_threads() {
+    for (size_t i = 0; i < m_num_ports; i++) {
+        m_schedulers[i]->stop_io_thread();
+    }
+}
+
+bool Stimulator::is_io_threaded() {
+    return m_num_ports > 0 && m_schedulers[0]->is_io_threaded();
+}
+
+bool Stimulator::check_io_threads() {
+    bool success = true;
+    UpdateStats update_stats;
+    if (!check_replies()) success = false;
+    for (size_t i = 0; i < m_num_ports; i++) {
+        if (m_schedulers[i]->io_failed()) success = false;
+        size_t io_count = m_schedulers[i]->get_update_count();
+        update_stats.messages += io_count - m_io_counts[i];
+        m_io_counts[i] = io_count;
+
+        size_t held_count = m_schedulers[i]->get_held_back_count();
+        update_stats.held_back += held_count - m_held_counts[i];
+        m_held_counts[i] = held_count;
+
+        TransportStats stats_now = m_transports[i]->get_stats();
+        update_stats.bytes_written += stats_now.bytes_written - m_io_stats[i].bytes_written;
+        update_stats.bytes_read    += stats_now.bytes_read - m_io_stats[i].bytes_read;
+        update_stats.write_calls   += stats_now.write_calls - m_io_stats[i].write_calls;
+        update_stats.read_calls    += stats_now.read_calls - m_io_stats[i].read_calls;
+        m_io_stats[i] = stats_now;
+    }
+    m_update_stats = update_stats;
+
+    if (!success) {
+        LOG(Error) << "An I/O thread failed, or a reply was invalid or an error. Disabling stimulator.";
+        disable();
+    }
+    return success;
+}
+
+bool Stimulator::start_readers() {
+    if (!is_enabled()) {
+        LOG(Error) << "Stimulator has not yet been enabled. Not starting the reply readers";
+        return false;
+    }
+    for (size_t i = m_readers.size(); i < m_num_ports; i++) {
+        m_readers.push_back(std::unique_ptr<ReplyReader>(new ReplyReader(*m_transports[i])));
+    }
+    for (size_t i = 0; i < m_readers.size(); i++) {
+        if (!m_readers[i]->start()) {
+            stop_readers();
+            return false;
+        }
+    }
+    return true;
+}
+
+bool Stimulator::stop_readers() {
+    bool were_running = false;
+    for (size_t i = 0; i < m_readers.size(); i++) {
+        if (m_readers[i]->is_running()) were_running = true;
+        m_readers[i]->stop();
+    }
+    return were_running;
+}
+
+bool Stimulator::check_replies() {
+    bool success  = true;
+    m_board_error = false;
+
+    // without the readers, fall back to reading whatever is waiting on the transports
+    if (m_readers.empty() || !m_readers[0]->is_running()) {
+        for (size_t i = 0; i < m_num_ports; i++) {
+            m_reply_board = i;
+            // the replies are only dispatched, so they are looked at where they were read into
+            ReadMessageView incoming_message;
+            while (!(incoming_message = read_message(*m_transports[i], m_reply, false)).empty()) {
+                if (!m_dispatcher.dispatch(incoming_message)){
+                    LOG(Error) << "Return message (below) was invalid.";
+                    print_message(incoming_message.get_message());
+                    success = false;
+                }
+            }
+        }
+        check_fire_replies();
+        return success && !m_board_error;
+    }
+
+    for (size_t i = 0; i < m_readers.size(); i++) {
+        m_reply_board = i;
+        while (m_readers[i]->pop(m_reply)) {
+            if (!m_dispatcher.dispatch(m_reply)) {
+                LOG(Error) << "Return message (below) was invalid.";
+                print_message(m_reply.get_message());
+                success = false;
+            }
+        }
+    }
+    check_fire_replies();
+    return success && !m_board_error;
+}
+
+void Stimulator::check_fire_replies() {
+    std::lock_guard<std::mutex> lock(m_fire_mtx);
+    if (m_fire_pending.empty()) return;
+
+    // the pulses are oldest first, so only those at the front can have timed out
+    Time   now     = m_fire_clock.get_elapsed_time();
+    size_t expired = 0;
+    while (expired < m_fire_pending.size() && now - m_fire_pending[expired].sent > m_fire_reply_timeout) {
+        LOG(Warning) << "The pulse fired on channel " << (int)m_fire_pending[expired].channel << " of board "
+                     << m_fire_pending[expired].board + 1 << " got no reply.";
+        expired++;
+    }
+    m_fire_pending.erase(m_fire_pending.begin(), m_fire_pending.begin() + expired);
+    m_fire_stats.unanswered += expired;
+}
+
 } // namespace fes
 } // namespace mahi
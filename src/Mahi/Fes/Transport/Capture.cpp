@@ -0,0 +1,311 @@
+// MIT License
+//
+// Copyright (c) 2020 Mechatronics and Haptic Interfaces Lab - Rice University
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// Author(s): Nathan Dunkelberger (nbd2@rice.edu)
+
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include <Mahi/Fes/Transport/Capture.hpp>
+#include <Mahi/Util.hpp>
+#include <chrono>
+#include <cstring>
+
+using namespace mahi::util;
+
+namespace mahi {
+namespace fes {
+
+namespace {
+/// how often the writer thread writes out a partly filled buffer
+const std::chrono::milliseconds FLUSH_INTERVAL(100);
+
+/// stores value_ as size_ little endian bytes at out_
+void put_le(unsigned char* out_, std::uint64_t value_, size_t size_) {
+    for (size_t i = 0; i < size_; i++) out_[i] = (unsigned char)(value_ >> (8 * i));
+}
+
+/// reads size_ little endian bytes at in_
+std::uint64_t get_le(const unsigned char* in_, size_t size_) {
+    std::uint64_t value = 0;
+    for (size_t i = 0; i < size_; i++) value |= (std::uint64_t)in_[i] << (8 * i);
+    return value;
+}
+}  // namespace
+
+CaptureWriter::CaptureWriter(size_t buffer_size_) :
+    m_file(nullptr),
+    m_active(0),
+    m_pending(false),
+    m_running(false) {
+    // every record must fit in a buffer on its own
+    if (buffer_size_ < CAPTURE_RECORD_HEADER_SIZE + 0xFFFF)
+        buffer_size_ = CAPTURE_RECORD_HEADER_SIZE + 0xFFFF;
+    m_buffers[0].resize(buffer_size_);
+    m_buffers[1].resize(buffer_size_);
+    m_fill[0] = 0;
+    m_fill[1] = 0;
+}
+
+CaptureWriter::~CaptureWriter() { close(); }
+
+bool CaptureWriter::open(const std::string& filename_) {
+    close();
+
+    m_file = std::fopen(filename_.c_str(), "wb");
+    if (m_file == nullptr) {
+        LOG(Error) << "Could not create capture file " << filename_;
+        return false;
+    }
+    if (std::fwrite(CAPTURE_MAGIC, 1, CAPTURE_MAGIC_SIZE, m_file) != CAPTURE_MAGIC_SIZE) {
+        LOG(Error) << "Could not write to capture file " << filename_;
+        std::fclose(m_file);
+        m_file = nullptr;
+        return false;
+    }
+
+    m_active    = 0;
+    m_pending   = false;
+    m_fill[0]   = 0;
+    m_fill[1]   = 0;
+    m_stats     = CaptureStats();
+    m_running   = true;
+    m_thread    = std::thread(&CaptureWriter::write_loop, this);
+    LOG(Info) << "Capturing link traffic to " << filename_;
+    return true;
+}
+
+void CaptureWriter::close() {
+    if (m_thread.joinable()) {
+        {
+            std::lock_guard<std::mutex> lock(m_mtx);
+            m_running = false;
+        }
+        m_cv.notify_one();
+        m_thread.join();
+    }
+    if (m_file != nullptr) {
+        std::fclose(m_file);
+        m_file = nullptr;
+        if (m_stats.dropped > 0)
+            LOG(Warning) << "Capture dropped " << m_stats.dropped << " records because the disk fell behind";
+    }
+}
+
+bool CaptureWriter::is_open() { return m_file != nullptr; }
+
+void CaptureWriter::attach(Transport& transport_, unsigned char port_) {
+    transport_.set_tap([this, port_](bool received_, const unsigned char* data_, size_t size_) {
+        record(port_, received_, data_, size_);
+    });
+}
+
+void CaptureWriter::record(unsigned char port_, bool received_, const unsigned char* data_, size_t size_) {
+    // take the time before waiting on anything, so it is as close to the I/O as possible
+    std::uint64_t time_ns = (std::uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                std::chrono::steady_clock::now().time_since_epoch())
+                                .count();
+
+    std::lock_guard<std::mutex> lock(m_mtx);
+    if (!m_running) return;
+
+    // sizes are stored in 16 bits, so anything longer is split over several records
+    size_t offset = 0;
+    do {
+        size_t chunk = size_ - offset;
+        if (chunk > 0xFFFF) chunk = 0xFFFF;
+        size_t needed = CAPTURE_RECORD_HEADER_SIZE + chunk;
+
+        if (m_fill[m_active] + needed > m_buffers[m_active].size() && !swap_buffers()) {
+            m_stats.dropped++;
+        } else {
+            unsigned char* out = &m_buffers[m_active][m_fill[m_active]];
+            put_le(out, time_ns, 8);
+            out[8] = port_;
+            out[9] = received_ ? 1 : 0;
+            put_le(out + 10, chunk, 2);
+            if (chunk > 0) std::memcpy(out + CAPTURE_RECORD_HEADER_SIZE, data_ + offset, chunk);
+            m_fill[m_active] += needed;
+            m_stats.records++;
+            m_stats.bytes += chunk;
+        }
+        offset += chunk;
+    } while (offset < size_);
+}
+
+CaptureStats CaptureWriter::get_stats() {
+    std::lock_guard<std::mutex> lock(m_mtx);
+    return m_stats;
+}
+
+bool CaptureWriter::swap_buffers() {
+    // the other buffer is still being written out
+    if (m_pending) return false;
+    m_pending = true;
+    m_active ^= 1;
+    m_fill[m_active] = 0;
+    m_cv.notify_one();
+    return true;
+}
+
+void CaptureWriter::write_loop() {
+    std::unique_lock<std::mutex> lock(m_mtx);
+    while (true) {
+        m_cv.wait_for(lock, FLUSH_INTERVAL, [this] { return m_pending || !m_running; });
+
+        // write out what has built up, even if the buffer is not full yet
+        if (!m_pending && m_fill[m_active] > 0) swap_buffers();
+
+        if (m_pending) {
+            int    full = m_active ^ 1;
+            size_t size = m_fill[full];
+            // only the writer thread touches the full buffer until m_pending is cleared, so the
+            // lock can be let go while the disk catches up
+            lock.unlock();
+            if (std::fwrite(m_buffers[full].data(), 1, size, m_file) != size)
+                LOG(Error) << "Could not write to the capture file";
+            std::fflush(m_file);
+            lock.lock();
+            m_fill[full] = 0;
+            m_pending    = false;
+            continue;
+        }
+
+        if (!m_running) break;
+    }
+}
+
+CaptureReader::CaptureReader() :
+    m_data(nullptr),
+    m_size(0),
+    m_offset(CAPTURE_MAGIC_SIZE),
+    m_file(nullptr),
+    m_mapping(nullptr) {}
+
+CaptureReader::~CaptureReader() { close(); }
+
+bool CaptureReader::open(const std::string& filename_) {
+    close();
+
+#ifdef _WIN32
+    HANDLE file = CreateFileA(filename_.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING,
+                              FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file == INVALID_HANDLE_VALUE) {
+        LOG(Error) << "Could not open capture file " << filename_;
+        return false;
+    }
+    m_file = file;
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size)) {
+        LOG(Error) << "Could not get the size of capture file " << filename_;
+        close();
+        return false;
+    }
+    m_size = (size_t)size.QuadPart;
+    if (m_size >= CAPTURE_MAGIC_SIZE) {
+        HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+        if (mapping != NULL) {
+            m_mapping = mapping;
+            m_data    = (const unsigned char*)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+        }
+    }
+#else
+    int fd = ::open(filename_.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd == -1) {
+        LOG(Error) << "Could not open capture file " << filename_;
+        return false;
+    }
+    struct stat info;
+    if (fstat(fd, &info) != 0) {
+        LOG(Error) << "Could not get the size of capture file " << filename_;
+        ::close(fd);
+        return false;
+    }
+    m_size = (size_t)info.st_size;
+    if (m_size >= CAPTURE_MAGIC_SIZE) {
+        void* data = mmap(NULL, m_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (data != MAP_FAILED) {
+            m_data = (const unsigned char*)data;
+            // records are read front to back
+            madvise(data, m_size, MADV_SEQUENTIAL);
+        }
+    }
+    // the mapping stays valid after the descriptor is closed
+    ::close(fd);
+#endif
+
+    if (m_size < CAPTURE_MAGIC_SIZE) {
+        LOG(Error) << "Capture file " << filename_ << " is too short";
+        close();
+        return false;
+    }
+    if (m_data == nullptr) {
+        LOG(Error) << "Could not map capture file " << filename_;
+        close();
+        return false;
+    }
+    if (std::memcmp(m_data, CAPTURE_MAGIC, CAPTURE_MAGIC_SIZE) != 0) {
+        LOG(Error) << filename_ << " is not a capture file";
+        close();
+        return false;
+    }
+
+    rewind();
+    return true;
+}
+
+void CaptureReader::close() {
+#ifdef _WIN32
+    if (m_data != nullptr) UnmapViewOfFile(m_data);
+    if (m_mapping != nullptr) CloseHandle((HANDLE)m_mapping);
+    if (m_file != nullptr) CloseHandle((HANDLE)m_file);
+#else
+    if (m_data != nullptr) munmap((void*)m_data, m_size);
+#endif
+    m_data    = nullptr;
+    m_mapping = nullptr;
+    m_file    = nullptr;
+    m_size    = 0;
+    rewind();
+}
+
+bool CaptureReader::next(CaptureRecord& record_) {
+    if (m_data == nullptr || m_offset + CAPTURE_RECORD_HEADER_SIZE > m_size) return false;
+
+    const unsigned char* in   = m_data + m_offset;
+    size_t               size = (size_t)get_le(in + 10, 2);
+    // the capture was cut off in the middle of this record
+    if (m_offset + CAPTURE_RECORD_HEADER_SIZE + size > m_size) return false;
+
+    record_.time_ns  = get_le(in, 8);
+    record_.port     = in[8];
+    record_.received = in[9] != 0;
+    record_.data     = in + CAPTURE_RECORD_HEADER_SIZE;
+    record_.size     = size;
+    m_offset += CAPTURE_RECORD_HEADER_SIZE + size;
+    return true;
+}
+
+void CaptureReader::rewind() { m_offset = CAPTURE_MAGIC_SIZE; }
+
+size_t CaptureReader::get_size() { return m_size; }
+
+}  // namespace fes
+}  // namespace mahi
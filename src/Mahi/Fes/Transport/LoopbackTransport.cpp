@@ -0,0 +1,81 @@
+// MIT License
+//
+// Copyright (c) 2020 Mechatronics and Haptic Interfaces Lab - Rice University
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// Author(s): Nathan Dunkelberger (nbd2@rice.edu)
+
+#include <Mahi/Fes/Transport/LoopbackTransport.hpp>
+#include <Mahi/Util.hpp>
+#include <algorithm>
+#include <chrono>
+
+using namespace mahi::util;
+
+namespace mahi {
+namespace fes {
+
+std::pair<std::unique_ptr<LoopbackTransport>, std::unique_ptr<LoopbackTransport>>
+LoopbackTransport::make_pair(const std::string& name_, unsigned int baud_rate_) {
+    std::shared_ptr<Pipe> a_to_b = std::make_shared<Pipe>();
+    std::shared_ptr<Pipe> b_to_a = std::make_shared<Pipe>();
+    std::unique_ptr<LoopbackTransport> a(new LoopbackTransport(name_ + " (host)", baud_rate_, a_to_b, b_to_a));
+    std::unique_ptr<LoopbackTransport> b(new LoopbackTransport(name_ + " (board)", baud_rate_, b_to_a, a_to_b));
+    return std::make_pair(std::move(a), std::move(b));
+}
+
+LoopbackTransport::LoopbackTransport(const std::string& name_, unsigned int baud_rate_,
+                                     std::shared_ptr<Pipe> tx_, std::shared_ptr<Pipe> rx_) :
+    Transport(name_, baud_rate_),
+    m_tx(tx_),
+    m_rx(rx_),
+    m_open(false) {}
+
+LoopbackTransport::~LoopbackTransport() { close(); }
+
+bool LoopbackTransport::open() {
+    m_open = true;
+    return true;
+}
+
+void LoopbackTransport::close() { m_open = false; }
+
+bool LoopbackTransport::is_open() { return m_open; }
+
+void LoopbackTransport::purge() {
+    std::lock_guard<std::mutex> lock(m_rx->mtx);
+    m_rx->bytes.clear();
+}
+
+bool LoopbackTransport::write_bytes(const unsigned char* data_, size_t size_) {
+    {
+        std::lock_guard<std::mutex> lock(m_tx->mtx);
+        m_tx->bytes.insert(m_tx->bytes.end(), data_, data_ + size_);
+    }
+    m_tx->cv.notify_all();
+    return true;
+}
+
+size_t LoopbackTransport::read_bytes(unsigned char* data_, size_t size_, Time timeout_) {
+    std::unique_lock<std::mutex> lock(m_rx->mtx);
+    if (m_rx->bytes.empty() && timeout_ > Time::Zero) {
+        m_rx->cv.wait_for(lock, std::chrono::microseconds(timeout_.as_microseconds()),
+                          [this] { return !m_rx->bytes.empty(); });
+    }
+    size_t count = std::min(size_, m_rx->bytes.size());
+    std::copy(m_rx->bytes.begin(), m_rx->bytes.begin() + count, data_);
+    m_rx->bytes.erase(m_rx->bytes.begin(), m_rx->bytes.begin() + count);
+    return count;
+}
+
+}  // namespace fes
+}  // namespace mahi
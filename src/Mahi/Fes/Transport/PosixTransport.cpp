@@ -0,0 +1,244 @@
+// MIT License
+//
+// Copyright (c) 2020 Mechatronics and Haptic Interfaces Lab - Rice University
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// Author(s): Nathan Dunkelberger (nbd2@rice.edu)
+
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/ioctl.h>
+#include <sys/epoll.h>
+#include <sys/timerfd.h>
+#include <termios.h>
+#include <unistd.h>
+
+#include <Mahi/Fes/Transport/PosixTransport.hpp>
+#include <Mahi/Util.hpp>
+#include <cstdint>
+
+using namespace mahi::util;
+
+namespace mahi {
+namespace fes {
+
+namespace {
+/// converts a baud rate in bits per second to the termios speed constant
+speed_t to_speed(unsigned int baud_rate) {
+    switch (baud_rate) {
+        case 1200:   return B1200;
+        case 2400:   return B2400;
+        case 4800:   return B4800;
+        case 9600:   return B9600;
+        case 19200:  return B19200;
+        case 38400:  return B38400;
+        case 57600:  return B57600;
+        case 115200: return B115200;
+        case 230400: return B230400;
+        default:     return B0;
+    }
+}
+
+/// closes a descriptor if it is open and marks it closed
+void close_fd(int& fd) {
+    if (fd != -1) {
+        ::close(fd);
+        fd = -1;
+    }
+}
+}  // namespace
+
+PosixTransport::PosixTransport(const std::string& device_, unsigned int baud_rate_) :
+    Transport(device_, baud_rate_),
+    m_fd(-1),
+    m_rx_epoll(-1),
+    m_rx_timer(-1),
+    m_tx_epoll(-1),
+    m_tx_timer(-1) {}
+
+PosixTransport::~PosixTransport() { close(); }
+
+bool PosixTransport::open() {
+    m_fd = ::open(m_name.c_str(), O_RDWR | O_NOCTTY | O_NONBLOCK | O_CLOEXEC);
+
+    if (m_fd == -1) {
+        LOG(Error) << "Failed to open port " << m_name;
+        return false;
+    } else {
+        LOG(Info) << "Successfully opened port " << m_name;
+    }
+
+    if (!configure_port() || !create_waiter(m_rx_epoll, m_rx_timer, EPOLLIN) ||
+        !create_waiter(m_tx_epoll, m_tx_timer, EPOLLOUT)) {
+        close();
+        return false;
+    }
+
+    return true;
+}
+
+bool PosixTransport::configure_port() {
+    speed_t speed = to_speed(m_baud_rate);
+    if (speed == B0) {
+        LOG(Error) << "Unsupported baud rate " << m_baud_rate << " for port " << m_name;
+        return false;
+    }
+
+    struct termios port_settings;
+    if (tcgetattr(m_fd, &port_settings) != 0) {
+        LOG(Error) << "Error getting serial port state";
+        return false;
+    }
+
+    cfsetispeed(&port_settings, speed);
+    cfsetospeed(&port_settings, speed);
+
+    port_settings.c_cflag &= ~PARENB;                          // no parity
+    port_settings.c_cflag &= ~CSTOPB;                          // one stop bit
+    port_settings.c_cflag &= ~CSIZE;                           // 8 data bits
+    port_settings.c_cflag |= CS8;
+    port_settings.c_cflag |= (CLOCAL | CREAD);                 // enable the receiver and set local mode
+    port_settings.c_cflag &= ~CRTSCTS;                         // no hardware flow control
+    port_settings.c_iflag &= ~(IXON | IXOFF | IXANY);          // no software flow control
+    port_settings.c_iflag &= ~(INLCR | ICRNL | IGNCR | ISTRIP | BRKINT | PARMRK);
+    port_settings.c_lflag &= ~(ICANON | ECHO | ECHOE | ISIG | IEXTEN);  // raw input
+    port_settings.c_oflag &= ~OPOST;                           // raw output
+
+    // the device is non-blocking, so reads return whatever is available and all waiting is
+    // done with epoll
+    port_settings.c_cc[VMIN]  = 0;
+    port_settings.c_cc[VTIME] = 0;
+
+    if (tcsetattr(m_fd, TCSANOW, &port_settings) != 0) {
+        LOG(Error) << "Error setting serial port state";
+        return false;
+    }
+
+    purge();
+
+    return true;
+}
+
+bool PosixTransport::create_waiter(int& epoll_fd_, int& timer_fd_, unsigned int events_) {
+    epoll_fd_ = epoll_create1(EPOLL_CLOEXEC);
+    timer_fd_ = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    if (epoll_fd_ == -1 || timer_fd_ == -1) {
+        LOG(Error) << "Could not create the epoll/timer descriptors for port " << m_name;
+        return false;
+    }
+
+    struct epoll_event device_event = {};
+    device_event.events  = events_;
+    device_event.data.fd = m_fd;
+    struct epoll_event timer_event = {};
+    timer_event.events  = EPOLLIN;
+    timer_event.data.fd = timer_fd_;
+    if (epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, m_fd, &device_event) != 0 ||
+        epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, timer_fd_, &timer_event) != 0) {
+        LOG(Error) << "Could not register port " << m_name << " with epoll";
+        return false;
+    }
+    return true;
+}
+
+bool PosixTransport::wait_ready(int epoll_fd_, int timer_fd_, Time timeout_) {
+    if (timeout_ <= Time::Zero) return false;
+
+    // arm the one-shot timeout
+    std::int64_t      timeout_us = timeout_.as_microseconds();
+    struct itimerspec deadline   = {};
+    deadline.it_value.tv_sec  = (time_t)(timeout_us / 1000000);
+    deadline.it_value.tv_nsec = (long)(timeout_us % 1000000) * 1000;
+    timerfd_settime(timer_fd_, 0, &deadline, NULL);
+
+    bool ready = false;
+    bool timed_out = false;
+    while (!ready && !timed_out) {
+        struct epoll_event events[2];
+        int count = epoll_wait(epoll_fd_, events, 2, -1);
+        if (count < 0) {
+            if (errno == EINTR) continue;
+            break;
+        }
+        for (int i = 0; i < count; i++) {
+            if (events[i].data.fd == m_fd) ready = true;
+            else timed_out = true;
+        }
+    }
+
+    // disarm and drain the timer so the next wait starts clean
+    struct itimerspec disarm = {};
+    timerfd_settime(timer_fd_, 0, &disarm, NULL);
+    std::uint64_t expirations;
+    while (::read(timer_fd_, &expirations, sizeof(expirations)) > 0) {}
+
+    return ready;
+}
+
+void PosixTransport::close() {
+    close_fd(m_rx_epoll);
+    close_fd(m_rx_timer);
+    close_fd(m_tx_epoll);
+    close_fd(m_tx_timer);
+    close_fd(m_fd);
+}
+
+bool PosixTransport::is_open() { return m_fd != -1; }
+
+void PosixTransport::purge() { tcflush(m_fd, TCIOFLUSH); }
+
+size_t PosixTransport::get_output_queue_depth() {
+    int queued = 0;
+    if (m_fd == -1 || ioctl(m_fd, TIOCOUTQ, &queued) == -1) return 0;
+    return queued > 0 ? (size_t)queued : 0;
+}
+
+bool PosixTransport::write_bytes(const unsigned char* data_, size_t size_) {
+    // same budget as the write timeouts used on Windows: 50 ms plus 10 ms per byte
+    Time  timeout = milliseconds(50 + 10 * (int)size_);
+    Clock write_clock;
+
+    size_t written = 0;
+    while (written < size_) {
+        ssize_t result = ::write(m_fd, data_ + written, size_ - written);
+        if (result >= 0) {
+            written += (size_t)result;
+        } else if (errno == EAGAIN || errno == EWOULDBLOCK) {
+            // the driver's transmit buffer is full, wait for room
+            if (!wait_ready(m_tx_epoll, m_tx_timer, timeout - write_clock.get_elapsed_time())) {
+                LOG(Error) << "Timed out writing to port " << m_name;
+                return false;
+            }
+        } else if (errno != EINTR) {
+            return false;
+        }
+    }
+    return true;
+}
+
+size_t PosixTransport::read_bytes(unsigned char* data_, size_t size_, Time timeout_) {
+    // take whatever is already there without waiting
+    ssize_t result = ::read(m_fd, data_, size_);
+    if (result > 0) return (size_t)result;
+
+    if (!wait_ready(m_rx_epoll, m_rx_timer, timeout_)) return 0;
+
+    result = ::read(m_fd, data_, size_);
+    return result > 0 ? (size_t)result : 0;
+}
+
+std::unique_ptr<Transport> make_serial_transport(const std::string& port_, unsigned int baud_rate_) {
+    return std::unique_ptr<Transport>(new PosixTransport(port_, baud_rate_));
+}
+
+}  // namespace fes
+}  // namespace mahi
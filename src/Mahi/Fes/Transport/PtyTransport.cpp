@@ -0,0 +1,85 @@
+// MIT License
+//
+// Copyright (c) 2020 Mechatronics and Haptic Interfaces Lab - Rice University
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// Author(s): Nathan Dunkelberger (nbd2@rice.edu)
+
+#include <fcntl.h>
+#include <stdlib.h>
+#include <sys/epoll.h>
+#include <unistd.h>
+
+#include <Mahi/Fes/Transport/PtyTransport.hpp>
+#include <Mahi/Util.hpp>
+
+using namespace mahi::util;
+
+namespace mahi {
+namespace fes {
+
+PtyTransport::PtyTransport(unsigned int baud_rate_) :
+    PosixTransport("pty", baud_rate_),
+    m_slave_fd(-1) {}
+
+PtyTransport::~PtyTransport() { close(); }
+
+bool PtyTransport::open() {
+    m_fd = posix_openpt(O_RDWR | O_NOCTTY | O_CLOEXEC);
+    if (m_fd == -1 || grantpt(m_fd) != 0 || unlockpt(m_fd) != 0) {
+        LOG(Error) << "Failed to create a pty";
+        close();
+        return false;
+    }
+
+    char slave_name[128];
+    if (ptsname_r(m_fd, slave_name, sizeof(slave_name)) != 0) {
+        LOG(Error) << "Failed to get the name of the pty slave";
+        close();
+        return false;
+    }
+    m_slave_name = slave_name;
+    m_name       = m_slave_name + " (master)";
+
+    // without anything holding the slave open, reads on the master fail with EIO and epoll
+    // keeps reporting a hang up until the other side opens it
+    m_slave_fd = ::open(slave_name, O_RDWR | O_NOCTTY | O_CLOEXEC);
+    if (m_slave_fd == -1 || fcntl(m_fd, F_SETFL, fcntl(m_fd, F_GETFL) | O_NONBLOCK) == -1) {
+        LOG(Error) << "Failed to open the pty slave " << m_slave_name;
+        close();
+        return false;
+    }
+
+    // settings made on the master apply to the line discipline of the slave, which has to be raw
+    // before the other side opens it, or whatever is written here gets echoed or translated
+    if (!configure_port() || !create_waiter(m_rx_epoll, m_rx_timer, EPOLLIN) ||
+        !create_waiter(m_tx_epoll, m_tx_timer, EPOLLOUT)) {
+        close();
+        return false;
+    }
+
+    LOG(Info) << "Created pty " << m_slave_name;
+    return true;
+}
+
+void PtyTransport::close() {
+    PosixTransport::close();
+    if (m_slave_fd != -1) {
+        ::close(m_slave_fd);
+        m_slave_fd = -1;
+    }
+}
+
+std::string PtyTransport::get_slave_name() { return m_slave_name; }
+
+}  // namespace fes
+}  // namespace mahi
@@ -0,0 +1,186 @@
+// MIT License
+//
+// Copyright (c) 2020 Mechatronics and Haptic Interfaces Lab - Rice University
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// Author(s): Nathan Dunkelberger (nbd2@rice.edu)
+
+#include <Mahi/Fes/Transport/Transport.hpp>
+#include <Mahi/Util.hpp>
+#include <cstring>
+
+using namespace mahi::util;
+
+namespace mahi {
+namespace fes {
+
+Transport::Transport(const std::string& name_, unsigned int baud_rate_) :
+    m_name(name_),
+    m_baud_rate(baud_rate_),
+    m_bytes_written(0),
+    m_bytes_read(0),
+    m_write_calls(0),
+    m_read_calls(0),
+    m_priority_writes(0),
+    m_tx_size(0),
+    m_tx_queued(0),
+    m_tx_window(TX_WINDOW_SIZE) {}
+
+Transport::~Transport() {}
+
+void Transport::purge() {}
+
+size_t Transport::get_output_queue_depth() { return 0; }
+
+size_t Transport::get_pending_bytes() { return m_tx_queued + get_output_queue_depth(); }
+
+bool Transport::write(const unsigned char* data_, size_t size_) {
+    if (!is_open()) {
+        LOG(Error) << "Transport " << m_name << " is not open. Not writing.";
+        return false;
+    }
+    std::lock_guard<std::mutex> lock(m_write_mtx);
+    // routine writes that are already waiting go first, so that they keep their order
+    bool success = pump();
+    if (m_tx_size == 0 && fits_window(size_)) return send(data_, size_) && success;
+
+    if (size_ > 0xFFFF || m_tx_size + 2 + size_ > TX_QUEUE_SIZE) {
+        LOG(Error) << "Transmit queue of " << m_name << " is full. Dropping " << size_ << " bytes.";
+        return false;
+    }
+    m_tx_queue[m_tx_size]     = (unsigned char)(size_ & 0xFF);
+    m_tx_queue[m_tx_size + 1] = (unsigned char)(size_ >> 8);
+    std::memcpy(m_tx_queue + m_tx_size + 2, data_, size_);
+    m_tx_size += 2 + size_;
+    m_tx_queued += size_;
+    return success;
+}
+
+bool Transport::write_priority(const unsigned char* data_, size_t size_) {
+    if (!is_open()) {
+        LOG(Error) << "Transport " << m_name << " is not open. Not writing.";
+        return false;
+    }
+    std::lock_guard<std::mutex> lock(m_write_mtx);
+    m_priority_writes++;
+    // straight to the device, so the routine writes waiting in the transport end up behind it
+    return send(data_, size_);
+}
+
+size_t Transport::discard_queued() {
+    std::lock_guard<std::mutex> lock(m_write_mtx);
+    size_t discarded = m_tx_queued;
+    m_tx_size        = 0;
+    m_tx_queued      = 0;
+    return discarded;
+}
+
+void Transport::set_transmit_window(size_t window_) {
+    std::lock_guard<std::mutex> lock(m_write_mtx);
+    m_tx_window = window_;
+}
+
+bool Transport::send(const unsigned char* data_, size_t size_) {
+    m_write_calls++;
+    if (!write_bytes(data_, size_)) {
+        return false;
+    }
+    m_bytes_written += size_;
+    if (m_tap) m_tap(false, data_, size_);
+    return true;
+}
+
+bool Transport::fits_window(size_t size_) {
+    if (m_tx_window == 0) return true;
+    // a write larger than the window still goes out whole, once the device has nothing queued
+    size_t depth = get_output_queue_depth();
+    return depth == 0 || depth + size_ <= m_tx_window;
+}
+
+bool Transport::pump() {
+    bool success = true;
+    while (m_tx_size > 0) {
+        size_t size = (size_t)m_tx_queue[0] | ((size_t)m_tx_queue[1] << 8);
+        if (!fits_window(size)) break;
+        if (!send(m_tx_queue + 2, size)) {
+            LOG(Error) << "Transport " << m_name << " failed to write " << size << " queued bytes.";
+            success = false;
+        }
+        // the queue is small, so moving the rest up is cheaper than keeping a ring
+        m_tx_size -= 2 + size;
+        std::memmove(m_tx_queue, m_tx_queue + 2 + size, m_tx_size);
+        m_tx_queued -= size;
+    }
+    return success;
+}
+
+size_t Transport::read(unsigned char* data_, size_t size_, Time timeout_) {
+    if (!is_open()) {
+        return 0;
+    }
+    // while routine writes are waiting in the transport, wait for the reply in short slices and
+    // keep handing them to the device in between, since the reply is usually waiting on them
+    size_t received = 0;
+    Clock  read_clock;
+    while (true) {
+        if (m_tx_queued > 0) {
+            std::lock_guard<std::mutex> lock(m_write_mtx);
+            pump();
+        }
+        Time left = timeout_ - read_clock.get_elapsed_time();
+        if (left < Time::Zero) left = Time::Zero;
+        bool sliced = m_tx_queued > 0 && left > milliseconds(1);
+        m_read_calls++;
+        received = read_bytes(data_, size_, sliced ? milliseconds(1) : left);
+        if (received > 0 || !sliced) break;
+    }
+    m_bytes_read += received;
+    if (m_tap && received > 0) m_tap(true, data_, received);
+    return received;
+}
+
+size_t Transport::read_exact(unsigned char* data_, size_t size_, Time timeout_) {
+    size_t received = read(data_, size_, timeout_);
+    if (received == 0) return 0;
+
+    // the frame has started, so give the remainder long enough to come over the wire
+    Time  remaining = timeout_ + microseconds(get_byte_time().as_microseconds() * size_) + milliseconds(10);
+    Clock frame_clock;
+    while (received < size_ && frame_clock.get_elapsed_time() < remaining) {
+        received += read(data_ + received, size_ - received, remaining - frame_clock.get_elapsed_time());
+    }
+    return received;
+}
+
+std::string Transport::get_name() { return m_name; }
+
+unsigned int Transport::get_baud_rate() { return m_baud_rate; }
+
+Time Transport::get_byte_time() {
+    // 8 data bits + start bit + stop bit
+    return microseconds(m_baud_rate > 0 ? 10 * 1000000 / m_baud_rate : 0);
+}
+
+void Transport::set_tap(Tap tap_) { m_tap = tap_; }
+
+TransportStats Transport::get_stats() {
+    TransportStats stats;
+    stats.bytes_written   = m_bytes_written;
+    stats.bytes_read      = m_bytes_read;
+    stats.write_calls     = m_write_calls;
+    stats.read_calls      = m_read_calls;
+    stats.priority_writes = m_priority_writes;
+    return stats;
+}
+
+}  // namespace fes
+}  // namespace mahi
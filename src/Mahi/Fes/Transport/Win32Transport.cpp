@@ -0,0 +1,206 @@
+// MIT License
+//
+// Copyright (c) 2020 Mechatronics and Haptic Interfaces Lab - Rice University
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// Author(s): Nathan Dunkelberger (nbd2@rice.edu)
+
+#include <Windows.h>
+#include <tchar.h>
+
+#include <Mahi/Fes/Transport/Win32Transport.hpp>
+#include <Mahi/Util.hpp>
+#include <codecvt>
+#include <locale>
+
+using namespace mahi::util;
+
+namespace mahi {
+namespace fes {
+
+Win32Transport::Win32Transport(const std::string& com_port_, unsigned int baud_rate_) :
+    Transport(com_port_, baud_rate_),
+    m_hComm(INVALID_HANDLE_VALUE),
+    m_read_event(NULL),
+    m_write_event(NULL) {}
+
+Win32Transport::~Win32Transport() { close(); }
+
+bool Win32Transport::open() {
+    // the comport must be formatted as an LPCWSTR, so we need to get it into that form from a
+    // std::string
+    std::wstring com_prefix = L"\\\\.\\";
+    std::wstring com_suffix =
+        std::wstring_convert<std::codecvt_utf8<wchar_t>>().from_bytes(m_name);
+    std::wstring comID = com_prefix + com_suffix;
+
+    m_hComm = CreateFileW(comID.c_str(),                 // port name
+                          GENERIC_READ | GENERIC_WRITE,  // Read/Write
+                          0,                             // No Sharing
+                          NULL,                          // No Security
+                          OPEN_EXISTING,                 // Open existing port only
+                          FILE_FLAG_OVERLAPPED,          // Overlapped I/O, so a pending read does not hold up writes
+                          NULL);                         // Null for Comm Devices
+
+    // Check if creating the comport was successful or not and log it
+    if (m_hComm == INVALID_HANDLE_VALUE) {
+        LOG(Error) << "Failed to open port " << m_name;
+        return false;
+    } else {
+        LOG(Info) << "Successfully opened port " << m_name;
+    }
+
+    // signaled when the pending read or write completes
+    m_read_event  = CreateEvent(NULL, TRUE, FALSE, NULL);
+    m_write_event = CreateEvent(NULL, TRUE, FALSE, NULL);
+    if (m_read_event == NULL || m_write_event == NULL) {
+        LOG(Error) << "Failed to create the I/O events for port " << m_name;
+        close();
+        return false;
+    }
+
+    if (!configure_port()) {
+        close();
+        return false;
+    }
+
+    return true;
+}
+
+bool Win32Transport::configure_port() {
+    // http://bd.eduweb.hhs.nl/micprg/pdf/serial-win.pdf
+
+    m_dcbSerialParams.DCBlength = sizeof(DCB);
+
+    if (!GetCommState(m_hComm, &m_dcbSerialParams)) {
+        LOG(Error) << "Error getting serial port state";
+        return false;
+    }
+
+    // set parameters to use for serial communication
+
+    // set the baud rate that we will communicate at (9600 by default)
+    m_dcbSerialParams.BaudRate = m_baud_rate;
+
+    // 8 bits in the bytes transmitted and received.
+    m_dcbSerialParams.ByteSize = 8;
+
+    // Specify that we are using one stop bit
+    m_dcbSerialParams.StopBits = ONESTOPBIT;
+
+    // Specify that we are using no parity
+    m_dcbSerialParams.Parity = NOPARITY;
+
+    // Disable all parameters dealing with flow control
+    m_dcbSerialParams.fOutX       = FALSE;
+    m_dcbSerialParams.fInX        = FALSE;
+    m_dcbSerialParams.fRtsControl = RTS_CONTROL_DISABLE;
+    m_dcbSerialParams.fDtrControl = DTR_CONTROL_DISABLE;
+
+    // Set communication parameters for the serial port
+    if (!SetCommState(m_hComm, &m_dcbSerialParams)) {
+        LOG(Error) << "Error setting serial port state";
+        return false;
+    }
+
+    // a read completes as soon as any bytes are there, and otherwise waits for the first one.
+    // read_bytes bounds the wait itself, and cancels the read if nothing arrives in time
+    COMMTIMEOUTS timeouts                = {0};
+    timeouts.ReadIntervalTimeout         = MAXDWORD;
+    timeouts.ReadTotalTimeoutMultiplier  = MAXDWORD;
+    timeouts.ReadTotalTimeoutConstant    = MAXDWORD - 1;
+    timeouts.WriteTotalTimeoutConstant   = 50;
+    timeouts.WriteTotalTimeoutMultiplier = 10;
+    if (!SetCommTimeouts(m_hComm, &timeouts)) {
+        LOG(Error) << "Error setting serial port timeouts";
+        return false;
+    }
+
+    purge();
+
+    return true;
+}
+
+void Win32Transport::close() {
+    if (m_hComm != INVALID_HANDLE_VALUE) {
+        CloseHandle(m_hComm);
+        m_hComm = INVALID_HANDLE_VALUE;
+    }
+    if (m_read_event != NULL) {
+        CloseHandle(m_read_event);
+        m_read_event = NULL;
+    }
+    if (m_write_event != NULL) {
+        CloseHandle(m_write_event);
+        m_write_event = NULL;
+    }
+}
+
+bool Win32Transport::is_open() { return m_hComm != INVALID_HANDLE_VALUE; }
+
+void Win32Transport::purge() {
+    PurgeComm(m_hComm, PURGE_TXABORT);
+    PurgeComm(m_hComm, PURGE_RXABORT);
+    PurgeComm(m_hComm, PURGE_RXCLEAR);
+    PurgeComm(m_hComm, PURGE_TXCLEAR);
+}
+
+size_t Win32Transport::get_output_queue_depth() {
+    DWORD   errors;
+    COMSTAT status;
+    if (!ClearCommError(m_hComm, &errors, &status)) return 0;
+    return (size_t)status.cbOutQue;
+}
+
+bool Win32Transport::write_bytes(const unsigned char* data_, size_t size_) {
+    OVERLAPPED overlapped = {0};
+    overlapped.hEvent     = m_write_event;
+    // Captures how many bytes were written
+    DWORD dwBytesWritten = 0;
+    if (!WriteFile(m_hComm, data_, (DWORD)size_, NULL, &overlapped) && GetLastError() != ERROR_IO_PENDING) {
+        return false;
+    }
+    // the write timeouts set in configure_port bound how long this waits
+    if (!GetOverlappedResult(m_hComm, &overlapped, &dwBytesWritten, TRUE)) {
+        return false;
+    }
+    return dwBytesWritten == (DWORD)size_;
+}
+
+size_t Win32Transport::read_bytes(unsigned char* data_, size_t size_, Time timeout_) {
+    OVERLAPPED overlapped = {0};
+    overlapped.hEvent     = m_read_event;
+    DWORD dwBytesRead     = 0;
+    if (!ReadFile(m_hComm, data_, (DWORD)size_, NULL, &overlapped) && GetLastError() != ERROR_IO_PENDING) {
+        LOG(Error) << "Could not read from port " << m_name;
+        return 0;
+    }
+
+    // round up, so that a short timeout still waits instead of returning right away
+    DWORD timeout_ms = timeout_ > Time::Zero ? (DWORD)((timeout_.as_microseconds() + 999) / 1000) : 0;
+    if (WaitForSingleObject(m_read_event, timeout_ms) != WAIT_OBJECT_0) {
+        // nothing arrived in time. Bytes that came in while cancelling are still in the result
+        CancelIoEx(m_hComm, &overlapped);
+    }
+    if (!GetOverlappedResult(m_hComm, &overlapped, &dwBytesRead, TRUE) && GetLastError() != ERROR_OPERATION_ABORTED) {
+        LOG(Error) << "Could not read from port " << m_name;
+        return 0;
+    }
+    return (size_t)dwBytesRead;
+}
+
+std::unique_ptr<Transport> make_serial_transport(const std::string& port_, unsigned int baud_rate_) {
+    return std::unique_ptr<Transport>(new Win32Transport(port_, baud_rate_));
+}
+
+}  // namespace fes
+}  // namespace mahi
@@ -1,31 +1,35 @@
 // #include <Mahi/Fes/Core/ReadMessage.hpp>
 #include <Mahi/Fes/Utility/Communication.hpp>
+#include <Mahi/Fes/Utility/ReplyParser.hpp>
 #include <Mahi/Util.hpp>
+#include <cstring>
 
 using namespace mahi::util;
 
 namespace mahi {
 namespace fes {
-std::vector<ReadMessage> get_all_messages(std::vector<HANDLE*> hComms, size_t num_ports) {
+std::vector<ReadMessage> get_all_messages(const std::vector<std::unique_ptr<Transport>>& transports) {
     std::vector<ReadMessage> incoming_messages;
-    for (size_t i = 0; i < num_ports; i++)
+    Reply                    buffer;
+    for (size_t i = 0; i < transports.size(); i++)
     {
         // while there are still messages, continue to read them
         while (true) {
-            std::vector<unsigned char> inc_message = read_message(*hComms[i], false);
+            ReadMessageView inc_message = read_message(*transports[i], buffer, false);
             // if there was no recent message, exit.
             if (inc_message.empty()){
                 break;
             }
             else{
-                incoming_messages.push_back(ReadMessage(inc_message));
+                // the messages are kept, so they need their own copy
+                incoming_messages.push_back(inc_message.to_message());
             }
         }
     }
     return incoming_messages;
 }
 
-void process_inc_messages(HANDLE hComm, std::queue<ReadMessage> &inc_messages) {
+void process_inc_messages(std::queue<ReadMessage> &inc_messages) {
     for (size_t i = 0; i < inc_messages.size(); i++) {
         ReadMessage current_message = inc_messages.front();
         inc_messages.pop();
@@ -33,50 +37,63 @@ void process_inc_messages(HANDLE hComm, std::queue<ReadMessage> &inc_messages) {
     }
 }
 
-std::vector<unsigned char> read_message(HANDLE hComm, bool should_wait, Time timeout) {
-    DWORD         header_size = 8;
-    unsigned char msg_header[8];
-    DWORD         dwBytesRead = 0;
+std::vector<unsigned char> read_message(Transport& transport, bool should_wait, Time timeout) {
+    Reply buffer;
+    return read_message(transport, buffer, should_wait, timeout).get_message();
+}
+
+namespace {
+/// a parser kept by each thread that reads messages, so one is not put together for every message
+struct MessageParser {
+    Reply*      target;  // where the next completed reply goes
+    ReplyParser parser;  // puts the reply together from the bytes read
 
-    bool  message_received = false;
-    Clock timeout_clock;
+    MessageParser() :
+        target(nullptr),
+        parser([this](const Reply& reply) {
+            std::memcpy(target->bytes, reply.bytes, reply.size);
+            target->size  = reply.size;
+            target->valid = reply.valid;
+        }) {}
+};
+}  // namespace
 
-    std::vector<unsigned char> msg;
+ReadMessageView read_message(Transport& transport, Reply& buffer, bool should_wait, Time timeout) {
+    static thread_local MessageParser message_parser;
+    ReplyParser&                      parser = message_parser.parser;
 
-    while (!message_received && ((timeout_clock.get_elapsed_time() < timeout) && should_wait)) {
-        if (!ReadFile(hComm, msg_header, header_size, &dwBytesRead, NULL)) {
-            LOG(Error) << "Could not read message header. Returning empty vector.";
-        } else if (dwBytesRead != 0) {
-            DWORD body_size = (unsigned int)msg_header[7] + 2;
+    // anything left from a message that never finished is of no use now. The parser resyncs on
+    // its own if what arrives first is not the start of a message
+    buffer.size           = 0;
+    message_parser.target = &buffer;
+    parser.reset();
 
-            std::unique_ptr<unsigned char[]> msg_body(new unsigned char[body_size]);
-            if (!ReadFile(hComm, msg_body.get(), body_size, &dwBytesRead, NULL)) {
-                LOG(Error) << "Could not read message body. Returning empty vector.";
-            } else {
-                if (msg_header[4] == (unsigned char)0x80 && msg_header[5] == (unsigned char)0x04) {
-                    for (unsigned int i = 0; i < (header_size + body_size); i++) {
-                        if (i < header_size) {
-                            msg.push_back(msg_header[i]);
-                        } else {
-                            msg.push_back(msg_body[i - header_size]);
-                        }
-                    }
-                    message_received = true;
-                } else {
-                    LOG(Error) << "Invalid Message Header Received: ";
-                    std::vector<unsigned char> msg_header_vec(std::begin(msg_header), std::end(msg_header));
-                    print_message(msg_header_vec);
-                    return msg_header_vec;
-                }
+    // a reply says how long it is, so the parser always knows how many bytes are still missing.
+    // Reading no more than that takes the message in a few chunks without consuming anything
+    // past its end. If we are not waiting, only take a message that is already on its way. Once
+    // a message has started, the rest is given time to come over the wire
+    Clock         read_clock;
+    Time          byte_timeout = transport.get_byte_time() + milliseconds(10);
+    unsigned char chunk[MAX_REPLY_SIZE];
+    bool          started = false;
+    while (buffer.size == 0) {
+        Time remaining = should_wait ? timeout - read_clock.get_elapsed_time() : Time::Zero;
+        Time wait      = started && remaining < byte_timeout ? byte_timeout : remaining;
+        size_t count   = transport.read(chunk, parser.get_bytes_needed(), wait);
+        if (count == 0) {
+            if (started) {
+                LOG(Error) << "Could not read a complete message. Returning empty vector.";
+            } else if (should_wait) {
+                LOG(Error) << "Ran into timeout when waiting to receive a message. Returning empty message instead.";
             }
+            break;
         }
+        started = true;
+        parser.feed(chunk, count);
     }
-    if (!message_received && should_wait) {
-        LOG(Error) << "Ran into timeout when waiting to receive a message. Returning empty message instead.";
-    }
-    // print_message(msg);
-    return msg;
+
+    return ReadMessageView(buffer.bytes, buffer.size);
 }
 
 }  // namespace fes
-}  // namespace mahi
\ No newline at end of file
+}  // namespace mahi
@@ -0,0 +1,81 @@
+// MIT License
+//
+// Copyright (c) 2020 Mechatronics and Haptic Interfaces Lab - Rice University
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// Author(s): Nathan Dunkelberger (nbd2@rice.edu)
+
+#include <Mahi/Fes/Utility/PortWorker.hpp>
+
+namespace mahi {
+namespace fes {
+
+PortWorker::PortWorker() :
+    m_has_task(false),
+    m_done(true),
+    m_result(true),
+    m_stop(false),
+    m_thread(&PortWorker::work_loop, this) {}
+
+PortWorker::~PortWorker() {
+    {
+        std::lock_guard<std::mutex> lock(m_mtx);
+        m_stop = true;
+    }
+    m_cv.notify_all();
+    m_thread.join();
+}
+
+void PortWorker::submit(std::function<bool()> task_) {
+    {
+        std::unique_lock<std::mutex> lock(m_mtx);
+        // m_task is in use until the task running now is done
+        m_cv.wait(lock, [this] { return m_done; });
+        m_task     = std::move(task_);
+        m_has_task = true;
+        m_done     = false;
+    }
+    m_cv.notify_all();
+}
+
+bool PortWorker::wait() {
+    std::unique_lock<std::mutex> lock(m_mtx);
+    m_cv.wait(lock, [this] { return m_done; });
+    return m_result;
+}
+
+bool PortWorker::is_done() {
+    std::lock_guard<std::mutex> lock(m_mtx);
+    return m_done;
+}
+
+void PortWorker::work_loop() {
+    std::unique_lock<std::mutex> lock(m_mtx);
+    while (true) {
+        m_cv.wait(lock, [this] { return m_has_task || m_stop; });
+        if (m_has_task) {
+            m_has_task = false;
+            // run the task without holding the lock, so that wait and is_done can be called meanwhile
+            lock.unlock();
+            bool result = m_task();
+            lock.lock();
+            m_result = result;
+            m_done   = true;
+            m_cv.notify_all();
+        } else if (m_stop) {
+            return;
+        }
+    }
+}
+
+}  // namespace fes
+}  // namespace mahi
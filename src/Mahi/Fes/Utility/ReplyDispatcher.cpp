@@ -0,0 +1,138 @@
+// MIT License
+//
+// Copyright (c) 2020 Mechatronics and Haptic Interfaces Lab - Rice University
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// Author(s): Nathan Dunkelberger (nbd2@rice.edu)
+
+
+#include <Mahi/Fes/Utility/ReplyDispatcher.hpp>
+#include <Mahi/Fes/Utility/Utility.hpp>
+
+namespace mahi {
+namespace fes {
+
+namespace {
+/// returns the data of reply_ if it is of type_ and holds at least size_ bytes, or nullptr
+const unsigned char* reply_data(const ReadMessageView& reply_, unsigned char type_, size_t size_) {
+    if (reply_.get_read_message_type() != type_ || reply_.get_data_size() < size_) return nullptr;
+    return reply_.get_data();
+}
+}  // namespace
+
+bool decode_reply(const ReadMessageView& reply_, ErrorReport& decoded_) {
+    const unsigned char* data = reply_data(reply_, ERROR_REPORT_MSG, 2);
+    if (data == nullptr) return false;
+    decoded_.error    = data[0];
+    decoded_.msg_type = data[1];
+    return true;
+}
+
+bool decode_reply(const ReadMessageView& reply_, EventErrorReport& decoded_) {
+    const unsigned char* data = reply_data(reply_, EVENT_ERROR_MSG, 4);
+    if (data == nullptr) return false;
+    decoded_.error      = data[0];
+    decoded_.event_id   = data[1];
+    decoded_.event_type = data[2];
+    decoded_.channel    = data[3];
+    return true;
+}
+
+bool decode_reply(const ReadMessageView& reply_, ScheduleCreatedReply& decoded_) {
+    const unsigned char* data = reply_data(reply_, CREATE_SCHEDULE_REPLY_MSG, 1);
+    if (data == nullptr) return false;
+    decoded_.schedule_id = data[0];
+    return true;
+}
+
+bool decode_reply(const ReadMessageView& reply_, EventCreatedReply& decoded_) {
+    const unsigned char* data = reply_data(reply_, CREATE_EVENT_REPLY_MSG, 4);
+    if (data == nullptr) return false;
+    decoded_.event_id    = data[0];
+    decoded_.schedule_id = data[1];
+    decoded_.event_type  = data[2];
+    decoded_.channel     = data[3];
+    return true;
+}
+
+bool decode_reply(const ReadMessageView& reply_, EventCommandReply& decoded_) {
+    const unsigned char* data = reply_data(reply_, EVENT_COMMAND_REPLY_MSG, 3);
+    if (data == nullptr) return false;
+    decoded_.event_id   = data[0];
+    decoded_.event_type = data[1];
+    decoded_.channel    = data[2];
+    return true;
+}
+
+template <typename Decoded>
+ReplyDispatcher::Handler ReplyDispatcher::make_handler(std::function<void(const Decoded&)> callback_) {
+    return [callback_](const ReadMessageView& reply_) -> bool {
+        Decoded decoded;
+        if (!decode_reply(reply_, decoded)) return false;
+        if (callback_) callback_(decoded);
+        return true;
+    };
+}
+
+ReplyDispatcher::ReplyDispatcher() {
+    // every type the UECU sends gets a handler, so that it is decoded even without a callback
+    on_error_report(nullptr);
+    on_event_error(nullptr);
+    on_schedule_created(nullptr);
+    on_event_created(nullptr);
+    on_event_command(nullptr);
+}
+
+void ReplyDispatcher::on_error_report(ErrorReportCallback callback_) {
+    m_handlers[ERROR_REPORT_MSG] = make_handler(callback_);
+}
+
+void ReplyDispatcher::on_event_error(EventErrorCallback callback_) {
+    m_handlers[EVENT_ERROR_MSG] = make_handler(callback_);
+}
+
+void ReplyDispatcher::on_schedule_created(ScheduleCreatedCallback callback_) {
+    m_handlers[CREATE_SCHEDULE_REPLY_MSG] = make_handler(callback_);
+}
+
+void ReplyDispatcher::on_event_created(EventCreatedCallback callback_) {
+    m_handlers[CREATE_EVENT_REPLY_MSG] = make_handler(callback_);
+}
+
+void ReplyDispatcher::on_event_command(EventCommandCallback callback_) {
+    m_handlers[EVENT_COMMAND_REPLY_MSG] = make_handler(callback_);
+}
+
+bool ReplyDispatcher::dispatch(const ReadMessageView& reply_) {
+    if (!reply_.crc_matches()) {
+        m_stats.crc_errors++;
+        return false;
+    }
+    const Handler& handler = m_handlers[reply_.get_read_message_type()];
+    if (!handler) {
+        m_stats.unknown++;
+        return false;
+    }
+    if (!handler(reply_)) {
+        m_stats.malformed++;
+        return false;
+    }
+    m_stats.dispatched++;
+    return true;
+}
+
+bool ReplyDispatcher::dispatch(const Reply& reply_) { return dispatch(ReadMessageView(reply_.bytes, reply_.size)); }
+
+ReplyDispatcherStats ReplyDispatcher::get_stats() { return m_stats; }
+
+}  // namespace fes
+}  // namespace mahi
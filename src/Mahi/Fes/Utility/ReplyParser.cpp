@@ -0,0 +1,141 @@
+// MIT License
+//
+// Copyright (c) 2020 Mechatronics and Haptic Interfaces Lab - Rice University
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// Author(s): Nathan Dunkelberger (nbd2@rice.edu)
+
+#include <Mahi/Fes/Core/ReadMessage.hpp>
+#include <Mahi/Fes/Utility/ReplyParser.hpp>
+#include <Mahi/Fes/Utility/Utility.hpp>
+#include <cstring>
+
+namespace mahi {
+namespace fes {
+
+namespace {
+/// number of header bytes up to and including the address pair
+const size_t ADDRESS_END = 6;
+}  // namespace
+
+ReplyParser::ReplyParser(Callback on_reply_) :
+    m_on_reply(on_reply_),
+    m_state(Seek),
+    m_expected(0),
+    m_crc(CRC_SEED),
+    m_rescan_pos(0),
+    m_rescan_size(0) {}
+
+void ReplyParser::feed(const unsigned char* data_, size_t size_) {
+    for (size_t i = 0; i < size_; i++) {
+        m_stats.bytes++;
+        step(data_[i]);
+        // a failed candidate puts its bytes back, and those come before anything newer
+        while (m_rescan_pos < m_rescan_size) {
+            step(m_rescan[m_rescan_pos++]);
+        }
+    }
+}
+
+void ReplyParser::reset() {
+    m_stats.discarded += m_reply.size + (m_rescan_size - m_rescan_pos);
+    m_state       = Seek;
+    m_reply.size  = 0;
+    m_rescan_pos  = 0;
+    m_rescan_size = 0;
+}
+
+ReplyParserStats ReplyParser::get_stats() { return m_stats; }
+
+size_t ReplyParser::get_bytes_needed() const {
+    const size_t min_reply = REPLY_HEADER_SIZE + REPLY_CRC_SIZE;
+    switch (m_state) {
+        case Seek:
+            // a full window was not the address pair, so at most its last bytes start a reply
+            return min_reply - (m_reply.size < ADDRESS_END ? m_reply.size : ADDRESS_END - 1);
+        case Type:
+        case Length:
+            return min_reply - m_reply.size;
+        case Body:
+            return m_expected - m_reply.size;
+    }
+    return 1;
+}
+
+void ReplyParser::step(unsigned char byte_) {
+    switch (m_state) {
+        case Seek:
+            // keep the last few bytes, since the address pair is preceded by the amulet bytes
+            if (m_reply.size == ADDRESS_END) {
+                std::memmove(m_reply.bytes, m_reply.bytes + 1, ADDRESS_END - 1);
+                m_reply.size--;
+                m_stats.discarded++;
+            }
+            m_reply.bytes[m_reply.size++] = byte_;
+            if (m_reply.size == ADDRESS_END && m_reply.bytes[4] == SRC_ADR && m_reply.bytes[5] == DEST_ADR) {
+                // from here on the crc is kept up to date as the bytes arrive
+                m_crc   = update_crc(CRC_SEED, m_reply.bytes, ADDRESS_END);
+                m_state = Type;
+            }
+            break;
+        case Type:
+            m_reply.bytes[m_reply.size++] = byte_;
+            m_crc   = update_crc(m_crc, byte_);
+            m_state = Length;
+            break;
+        case Length:
+            m_reply.bytes[m_reply.size++] = byte_;
+            m_crc      = update_crc(m_crc, byte_);
+            m_expected = REPLY_HEADER_SIZE + byte_ + REPLY_CRC_SIZE;
+            m_state    = Body;
+            break;
+        case Body:
+            // the crc covers everything but itself
+            if (m_reply.size < m_expected - REPLY_CRC_SIZE) m_crc = update_crc(m_crc, byte_);
+            m_reply.bytes[m_reply.size++] = byte_;
+            if (m_reply.size == m_expected) finish();
+            break;
+    }
+}
+
+void ReplyParser::finish() {
+    size_t       size = m_reply.size;
+    unsigned int crc  = m_crc;
+
+    m_state      = Seek;
+    m_reply.size = 0;
+
+    if (m_reply.bytes[size - 2] == (unsigned char)(crc & 0xFF) &&
+        m_reply.bytes[size - 1] == (unsigned char)(crc >> 8)) {
+        m_reply.size  = size;
+        m_reply.valid = is_reply_type(m_reply.bytes[6]);
+        m_stats.replies++;
+        m_on_reply(m_reply);
+        m_reply.size = 0;
+        return;
+    }
+
+    // the first byte is not the start of a reply, but a real one could start anywhere after it.
+    // Those bytes go in front of whatever was still waiting to be looked through. This never
+    // needs more room than one reply, since the candidate either started inside the waiting
+    // bytes (so they shrink) or after all of them (so none are left)
+    m_stats.crc_errors++;
+    m_stats.discarded++;
+    size_t remaining = m_rescan_size - m_rescan_pos;
+    std::memmove(m_rescan + size - 1, m_rescan + m_rescan_pos, remaining);
+    std::memcpy(m_rescan, m_reply.bytes + 1, size - 1);
+    m_rescan_pos  = 0;
+    m_rescan_size = size - 1 + remaining;
+}
+
+}  // namespace fes
+}  // namespace mahi
@@ -0,0 +1,88 @@
+// MIT License
+//
+// Copyright (c) 2020 Mechatronics and Haptic Interfaces Lab - Rice University
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// Author(s): Nathan Dunkelberger (nbd2@rice.edu)
+
+#include <Mahi/Fes/Utility/ReplyReader.hpp>
+#include <Mahi/Util.hpp>
+#include <functional>
+
+using namespace mahi::util;
+
+namespace mahi {
+namespace fes {
+
+ReplyReader::ReplyReader(Transport& transport_) :
+    m_transport(transport_),
+    m_parser(std::bind(&ReplyReader::on_reply, this, std::placeholders::_1)),
+    m_running(false),
+    m_reply_count(0),
+    m_crc_errors(0),
+    m_dropped(0),
+    m_discarded(0) {}
+
+ReplyReader::~ReplyReader() { stop(); }
+
+bool ReplyReader::start() {
+    if (m_running) return true;
+    if (!m_transport.is_open()) {
+        LOG(Error) << "Transport " << m_transport.get_name() << " is not open. Not starting the reply reader";
+        return false;
+    }
+    m_parser.reset();
+    m_running = true;
+    m_thread  = std::thread(&ReplyReader::read_loop, this);
+    return true;
+}
+
+void ReplyReader::stop() {
+    m_running = false;
+    if (m_thread.joinable()) m_thread.join();
+}
+
+bool ReplyReader::is_running() { return m_running; }
+
+bool ReplyReader::pop(Reply& reply_) { return m_replies.pop(reply_); }
+
+ReplyReaderStats ReplyReader::get_stats() {
+    ReplyReaderStats stats;
+    stats.replies    = m_reply_count;
+    stats.crc_errors = m_crc_errors;
+    stats.dropped    = m_dropped;
+    stats.discarded  = m_discarded;
+    return stats;
+}
+
+void ReplyReader::read_loop() {
+    while (m_running) {
+        // the read returns as soon as any data arrives, so the timeout only bounds how long it
+        // takes to notice stop() while the board is quiet
+        size_t count = m_transport.read(m_rx_buffer, RX_BUFFER_SIZE, milliseconds(10));
+        if (count > 0) {
+            m_parser.feed(m_rx_buffer, count);
+
+            ReplyParserStats parser_stats = m_parser.get_stats();
+            m_reply_count = parser_stats.replies;
+            m_crc_errors  = parser_stats.crc_errors;
+            m_discarded   = parser_stats.discarded;
+        }
+    }
+}
+
+void ReplyReader::on_reply(const Reply& reply_) {
+    if (!m_replies.push(reply_)) m_dropped++;
+}
+
+}  // namespace fes
+}  // namespace mahi
@@ -0,0 +1,142 @@
+// MIT License
+//
+// Copyright (c) 2020 Mechatronics and Haptic Interfaces Lab - Rice University
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// Author(s): Nathan Dunkelberger (nbd2@rice.edu)
+
+#include <Mahi/Fes/Transport/Capture.hpp>
+#include <Mahi/Fes/Utility/SessionReplay.hpp>
+#include <algorithm>
+#include <cstring>
+
+using namespace mahi::util;
+
+namespace mahi {
+namespace fes {
+
+SessionReplay::SessionReplay() : m_speed(1.0), m_reply_timeout(milliseconds(500)) {}
+
+bool SessionReplay::load(const std::string& filename_, unsigned char port_) {
+    m_writes.clear();
+    m_tx_bytes.clear();
+    m_expected.clear();
+
+    CaptureReader reader;
+    if (!reader.open(filename_)) return false;
+
+    // the replies are put back together the same way the stimulator does it
+    ReplyParser   parser([this](const Reply& reply_) { m_expected.push_back(reply_); });
+    CaptureRecord record;
+    while (reader.next(record)) {
+        if (record.port != port_) continue;
+        if (record.received) {
+            parser.feed(record.data, record.size);
+        } else if (record.size > 0) {
+            Write write;
+            write.time_ns = record.time_ns;
+            write.offset  = m_tx_bytes.size();
+            write.size    = record.size;
+            m_writes.push_back(write);
+            m_tx_bytes.insert(m_tx_bytes.end(), record.data, record.data + record.size);
+        }
+    }
+
+    if (m_writes.empty()) {
+        LOG(Error) << "Capture file " << filename_ << " has no writes on port " << (int)port_;
+        return false;
+    }
+    LOG(Info) << "Loaded " << m_writes.size() << " writes and " << m_expected.size() << " replies from "
+              << filename_;
+    return true;
+}
+
+void SessionReplay::set_speed(double speed_) { m_speed = speed_ > 0 ? speed_ : 0; }
+
+void SessionReplay::set_reply_timeout(Time reply_timeout_) { m_reply_timeout = reply_timeout_; }
+
+ReplayResult SessionReplay::run(Transport& transport_) {
+    ReplayResult result;
+    m_received.clear();
+    if (m_writes.empty()) {
+        LOG(Error) << "No session has been loaded. Nothing to replay";
+        return result;
+    }
+
+    ReplyParser parser([this](const Reply& reply_) { m_received.push_back(reply_); });
+
+    std::uint64_t first_ns = m_writes.front().time_ns;
+    Clock         clock;
+    for (auto& write : m_writes) {
+        if (m_speed > 0) {
+            // read replies while waiting for the write to be due
+            Time due = microseconds((std::int64_t)((write.time_ns - first_ns) / 1000 / m_speed));
+            Time now = clock.get_elapsed_time();
+            while (now < due) {
+                size_t count = transport_.read(m_rx_buffer, sizeof(m_rx_buffer), due - now);
+                if (count > 0) parser.feed(m_rx_buffer, count);
+                now = clock.get_elapsed_time();
+            }
+            if (now - due > result.max_lag) result.max_lag = now - due;
+        }
+
+        if (!transport_.write(&m_tx_bytes[write.offset], write.size)) {
+            LOG(Error) << "Could not write to " << transport_.get_name() << ". Stopping the replay";
+            break;
+        }
+        result.writes++;
+        result.bytes += write.size;
+
+        // take whatever has already come back without waiting
+        size_t count;
+        while ((count = transport_.read(m_rx_buffer, sizeof(m_rx_buffer), Time::Zero)) > 0) {
+            parser.feed(m_rx_buffer, count);
+        }
+    }
+    result.replay_duration   = clock.get_elapsed_time();
+    result.recorded_duration = microseconds((std::int64_t)((m_writes.back().time_ns - first_ns) / 1000));
+
+    // wait for the last replies until the link goes quiet
+    size_t count;
+    while ((count = transport_.read(m_rx_buffer, sizeof(m_rx_buffer), m_reply_timeout)) > 0) {
+        parser.feed(m_rx_buffer, count);
+    }
+
+    result.expected_replies = m_expected.size();
+    result.received_replies = m_received.size();
+    size_t replies = std::max(m_expected.size(), m_received.size());
+    for (size_t i = 0; i < replies; i++) {
+        bool has_expected = i < m_expected.size();
+        bool has_actual   = i < m_received.size();
+        if (has_expected && has_actual && m_expected[i].size == m_received[i].size &&
+            std::memcmp(m_expected[i].bytes, m_received[i].bytes, m_expected[i].size) == 0) {
+            result.matched++;
+            continue;
+        }
+        result.mismatched++;
+        if (result.diffs.size() < REPLAY_MAX_DIFFS) {
+            ReplayDiff diff;
+            diff.index = i;
+            if (has_expected) diff.expected = m_expected[i].get_message();
+            if (has_actual) diff.actual = m_received[i].get_message();
+            result.diffs.push_back(diff);
+        }
+    }
+    return result;
+}
+
+size_t SessionReplay::get_write_count() { return m_writes.size(); }
+
+size_t SessionReplay::get_reply_count() { return m_expected.size(); }
+
+}  // namespace fes
+}  // namespace mahi
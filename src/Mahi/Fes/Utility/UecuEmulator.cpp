@@ -0,0 +1,429 @@
+// MIT License
+//
+// Copyright (c) 2020 Mechatronics and Haptic Interfaces Lab - Rice University
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// Author(s): Nathan Dunkelberger (nbd2@rice.edu)
+
+#include <Mahi/Fes/Core/Event.hpp>
+#include <Mahi/Fes/Core/ReadMessage.hpp>
+#include <Mahi/Fes/Utility/UecuEmulator.hpp>
+#include <Mahi/Fes/Utility/Utility.hpp>
+#include <Mahi/Util.hpp>
+#include <algorithm>
+
+using namespace mahi::util;
+
+namespace mahi {
+namespace fes {
+
+namespace {
+/// returns the message length the host must use for a message of type_, or -1 if the length
+/// depends on the message
+int expected_length(unsigned char type_) {
+    switch (type_) {
+        case HALT_MSG:                  return HALT_LEN;
+        case CREATE_SCHEDULE_MSG:       return CREATE_SCHED_LEN;
+        case DELETE_SCHEDULE_MSG:       return 1;
+        case CHANGE_SCHEDULE_MSG:       return CHANGE_SCHED_LEN;
+        case CHANGE_SCHEDULE_STATE_MSG: return CHANGE_SCHED_STATE_LEN;
+        case CREATE_EVENT_MSG:          return CR_EVT_LEN;
+        case DELETE_EVENT_MSG:          return DELETE_EVENT_LEN;
+        case CHANGE_EVENT_SCHED_MSG:    return CHANGE_EVENT_SCHED_LEN;
+        case CHANGE_EVENT_PARAMS_MSG:   return CHANGE_EVENT_PARAMS_LEN;
+        case SYNC_MSG:                  return SYNC_MSG_LEN;
+        case CHANNEL_SETUP_MSG:         return CH_SET_LEN;
+        default:                        return -1;
+    }
+}
+
+/// combines the two bytes of a 16 bit value sent high byte first
+unsigned int twobytes_to_int(unsigned char high_, unsigned char low_) { return ((unsigned int)high_ << 8) | low_; }
+}  // namespace
+
+UecuEmulator::UecuEmulator(Transport& transport_) :
+    m_transport(transport_),
+    m_running(false) {}
+
+UecuEmulator::~UecuEmulator() { stop(); }
+
+bool UecuEmulator::start() {
+    if (m_running) return true;
+    if (!m_transport.is_open()) {
+        LOG(Error) << "Transport " << m_transport.get_name() << " is not open. Not starting the emulator";
+        return false;
+    }
+    m_running = true;
+    m_thread  = std::thread(&UecuEmulator::read_loop, this);
+    return true;
+}
+
+void UecuEmulator::stop() {
+    m_running = false;
+    if (m_thread.joinable()) m_thread.join();
+}
+
+bool UecuEmulator::is_running() { return m_running; }
+
+void UecuEmulator::feed(const unsigned char* data_, size_t size_) {
+    std::lock_guard<std::mutex> lock(m_mtx);
+    for (size_t i = 0; i < size_; i++) feed_byte(data_[i]);
+}
+
+void UecuEmulator::set_on_message(MessageCallback on_message_) { m_on_message = on_message_; }
+
+void UecuEmulator::reset() {
+    std::lock_guard<std::mutex> lock(m_mtx);
+    for (size_t i = 0; i < UECU_NUM_CHANNELS; i++) m_channels[i] = ChannelState();
+    m_schedules.clear();
+    m_events.clear();
+    m_frame.clear();
+    m_checked = 0;
+}
+
+UecuEmulator::ChannelState UecuEmulator::get_channel(unsigned char channel_) {
+    std::lock_guard<std::mutex> lock(m_mtx);
+    return channel_ < UECU_NUM_CHANNELS ? m_channels[channel_] : ChannelState();
+}
+
+std::vector<UecuEmulator::ScheduleState> UecuEmulator::get_schedules() {
+    std::lock_guard<std::mutex> lock(m_mtx);
+    return m_schedules;
+}
+
+std::vector<UecuEmulator::EventState> UecuEmulator::get_events() {
+    std::lock_guard<std::mutex> lock(m_mtx);
+    return m_events;
+}
+
+UecuEmulatorStats UecuEmulator::get_stats() {
+    std::lock_guard<std::mutex> lock(m_mtx);
+    return m_stats;
+}
+
+void UecuEmulator::read_loop() {
+    unsigned char rx_buffer[256];
+    while (m_running) {
+        // the timeout only bounds how long it takes to notice stop()
+        size_t count = m_transport.read(rx_buffer, sizeof(rx_buffer), milliseconds(10));
+        if (count > 0) feed(rx_buffer, count);
+    }
+}
+
+void UecuEmulator::feed_byte(unsigned char byte_) {
+    m_frame.push_back(byte_);
+
+    // after a resync, the bytes left in m_frame are looked at again one at a time, as if they had
+    // just arrived
+    while (m_checked < m_frame.size()) {
+        size_t size = ++m_checked;
+
+        // every message starts with the board address followed by the host address
+        if ((size == 1 && m_frame[0] != DEST_ADR) || (size == 2 && m_frame[1] != SRC_ADR)) {
+            resync();
+            continue;
+        }
+
+        // wait for the header, message and checksum
+        if (size < 4 || size < (size_t)m_frame[3] + 5) continue;
+
+        unsigned int sum = 0;
+        for (size_t i = 0; i < size - 1; i++) sum += m_frame[i];
+        unsigned char checksum = (unsigned char)(((sum & 0xFF) + (sum >> 8)) ^ 0xFF);
+
+        if (checksum != m_frame[size - 1]) {
+            m_stats.checksum_errors++;
+            send_error(UECU_ERR_CHECKSUM, m_frame[2]);
+            resync();
+            continue;
+        }
+
+        m_stats.messages++;
+        if (m_on_message) m_on_message(&m_frame[0], size);
+        handle_message();
+        m_frame.erase(m_frame.begin(), m_frame.begin() + size);
+        m_checked = 0;
+    }
+}
+
+void UecuEmulator::resync() {
+    m_frame.erase(m_frame.begin());
+    m_checked = 0;
+    m_stats.discarded++;
+}
+
+void UecuEmulator::handle_message() {
+    unsigned char        type   = m_frame[2];
+    unsigned char        length = m_frame[3];
+    const unsigned char* data   = &m_frame[4];
+
+    int expected = expected_length(type);
+    if (expected != -1 && expected != length) {
+        send_error(UECU_ERR_LENGTH, type);
+        return;
+    }
+
+    switch (type) {
+        case CHANNEL_SETUP_MSG: {
+            if (data[0] >= UECU_NUM_CHANNELS) {
+                send_error(UECU_ERR_CHANNEL, type);
+                return;
+            }
+            ChannelState& channel = m_channels[data[0]];
+            channel.configured    = true;
+            channel.max_amplitude = data[1];
+            channel.max_pw        = data[2];
+            channel.ip_delay      = twobytes_to_int(data[3], data[4]);
+            channel.aspect        = data[5];
+            channel.anode_cathode = data[6];
+            return;
+        }
+        case CREATE_SCHEDULE_MSG: {
+            if (m_schedules.size() >= UECU_MAX_SCHEDULES) {
+                send_error(UECU_ERR_FULL, type);
+                return;
+            }
+            ScheduleState schedule;
+            schedule.id = 1;
+            while (find_schedule(schedule.id) != nullptr) schedule.id++;
+            schedule.sync_char = data[0];
+            schedule.duration  = twobytes_to_int(data[1], data[2]);
+            m_schedules.push_back(schedule);
+            send_reply(CREATE_SCHEDULE_REPLY_MSG, &schedule.id, 1);
+            return;
+        }
+        case DELETE_SCHEDULE_MSG: {
+            if (find_schedule(data[0]) == nullptr) {
+                send_error(UECU_ERR_NO_SCHEDULE, type);
+                return;
+            }
+            unsigned char id = data[0];
+            m_events.erase(std::remove_if(m_events.begin(), m_events.end(),
+                                          [id](const EventState& event) { return event.schedule_id == id; }),
+                           m_events.end());
+            m_schedules.erase(std::remove_if(m_schedules.begin(), m_schedules.end(),
+                                             [id](const ScheduleState& schedule) { return schedule.id == id; }),
+                              m_schedules.end());
+            return;
+        }
+        case CHANGE_SCHEDULE_MSG: {
+            ScheduleState* schedule = find_schedule(data[0]);
+            if (schedule == nullptr) {
+                send_error(UECU_ERR_NO_SCHEDULE, type);
+                return;
+            }
+            unsigned int duration = twobytes_to_int(data[2], data[3]);
+            for (size_t i = 0; i < m_events.size(); i++) {
+                if (m_events[i].schedule_id == schedule->id && m_events[i].delay > duration) {
+                    send_error(UECU_ERR_DELAY, type);
+                    return;
+                }
+            }
+            schedule->sync_char = data[1];
+            schedule->duration  = duration;
+            return;
+        }
+        case CHANGE_SCHEDULE_STATE_MSG: {
+            ScheduleState* schedule = find_schedule(data[0]);
+            if (schedule == nullptr) {
+                send_error(UECU_ERR_NO_SCHEDULE, type);
+                return;
+            }
+            schedule->running = data[1] != 0x00;
+            return;
+        }
+        case CREATE_EVENT_MSG: {
+            ScheduleState* schedule = find_schedule(data[0]);
+            if (schedule == nullptr) {
+                send_error(UECU_ERR_NO_SCHEDULE, type);
+                return;
+            }
+            if (m_events.size() >= UECU_MAX_EVENTS) {
+                send_error(UECU_ERR_FULL, type);
+                return;
+            }
+            EventState event;
+            event.schedule_id = data[0];
+            event.delay       = twobytes_to_int(data[1], data[2]);
+            event.priority    = data[3];
+            event.type        = data[4];
+            event.channel     = data[5];
+            event.pulse_width = data[6];
+            event.amplitude   = data[7];
+            event.zone        = data[8];
+            if (event.channel >= UECU_NUM_CHANNELS || !m_channels[event.channel].configured) {
+                send_error(UECU_ERR_CHANNEL, type);
+                return;
+            }
+            if (event.delay > schedule->duration) {
+                send_error(UECU_ERR_DELAY, type);
+                return;
+            }
+            if (event.pulse_width > m_channels[event.channel].max_pw ||
+                event.amplitude > m_channels[event.channel].max_amplitude) {
+                send_error(UECU_ERR_LIMIT, type);
+                return;
+            }
+            event.id = 1;
+            while (find_event(event.id) != nullptr) event.id++;
+            m_events.push_back(event);
+
+            unsigned char reply[] = {event.id, event.schedule_id, event.type, event.channel};
+            send_reply(CREATE_EVENT_REPLY_MSG, reply, sizeof(reply));
+            return;
+        }
+        case DELETE_EVENT_MSG: {
+            if (find_event(data[0]) == nullptr) {
+                send_error(UECU_ERR_NO_EVENT, type);
+                return;
+            }
+            unsigned char id = data[0];
+            m_events.erase(std::remove_if(m_events.begin(), m_events.end(),
+                                          [id](const EventState& event) { return event.id == id; }),
+                           m_events.end());
+            return;
+        }
+        case CHANGE_EVENT_SCHED_MSG: {
+            EventState*    event    = find_event(data[0]);
+            ScheduleState* schedule = find_schedule(data[1]);
+            if (event == nullptr) {
+                send_error(UECU_ERR_NO_EVENT, type);
+                return;
+            }
+            if (schedule == nullptr) {
+                send_error(UECU_ERR_NO_SCHEDULE, type);
+                return;
+            }
+            unsigned int delay = twobytes_to_int(data[2], data[3]);
+            if (delay > schedule->duration) {
+                send_error(UECU_ERR_DELAY, type);
+                return;
+            }
+            event->schedule_id = data[1];
+            event->delay       = delay;
+            event->priority    = data[4];
+            return;
+        }
+        case CHANGE_EVENT_PARAMS_MSG: {
+            EventState* event = find_event(data[0]);
+            if (event == nullptr) {
+                send_error(UECU_ERR_NO_EVENT, type);
+                return;
+            }
+            if (!check_limits(*event, data[1], data[2])) return;
+            event->pulse_width = data[1];
+            event->amplitude   = data[2];
+            event->zone        = data[3];
+            return;
+        }
+        case SYNC_MSG: {
+            // every schedule waiting for this sync signal starts
+            for (size_t i = 0; i < m_schedules.size(); i++) {
+                if (m_schedules[i].sync_char == data[0]) m_schedules[i].running = true;
+            }
+            return;
+        }
+        case HALT_MSG: {
+            ScheduleState* schedule = find_schedule(data[0]);
+            if (schedule == nullptr) {
+                send_error(UECU_ERR_NO_SCHEDULE, type);
+                return;
+            }
+            schedule->running = false;
+            return;
+        }
+        case EVENT_COMMAND_MSG: {
+            // event type, priority and port/channel, followed by the parameters of the event type
+            if (length < 3) {
+                send_error(UECU_ERR_LENGTH, type);
+                return;
+            }
+            unsigned char channel = data[2];
+            if (channel >= UECU_NUM_CHANNELS || !m_channels[channel].configured) {
+                send_error(UECU_ERR_CHANNEL, type);
+                return;
+            }
+            if (data[0] == STIM_EVENT) {
+                if (length != STIM_EVENT_COMMAND_LEN) {
+                    send_error(UECU_ERR_LENGTH, type);
+                    return;
+                }
+                if (data[3] > m_channels[channel].max_pw || data[4] > m_channels[channel].max_amplitude) {
+                    send_error(UECU_ERR_LIMIT, type);
+                    return;
+                }
+            }
+            // an immediate event has no event id of its own
+            unsigned char reply[] = {0x00, data[0], channel};
+            send_reply(EVENT_COMMAND_REPLY_MSG, reply, sizeof(reply));
+            return;
+        }
+        default:
+            send_error(UECU_ERR_UNKNOWN_MSG, type);
+            return;
+    }
+}
+
+void UecuEmulator::send_reply(unsigned char type_, const unsigned char* data_, size_t size_) {
+    // the Amulet header, the UECU header, the data, and the crc low byte first
+    unsigned char header[] = {0x02, 0x34, 0xAA, (unsigned char)(size_ + 4), SRC_ADR, DEST_ADR, type_, (unsigned char)size_};
+    m_reply.reserve(sizeof(header) + size_ + 2);
+    m_reply.assign(header, header + sizeof(header));
+    m_reply.insert(m_reply.end(), data_, data_ + size_);
+    unsigned int crc = calc_crc(&m_reply[0], m_reply.size());
+    m_reply.push_back((unsigned char)(crc & 0xFF));
+    m_reply.push_back((unsigned char)((crc >> 8) & 0xFF));
+
+    if (!m_transport.write(&m_reply[0], m_reply.size())) {
+        LOG(Error) << "Emulator failed to reply on " << m_transport.get_name();
+        return;
+    }
+    m_stats.replies++;
+}
+
+void UecuEmulator::send_error(unsigned char error_code_, unsigned char failed_type_) {
+    unsigned char report[] = {error_code_, failed_type_};
+    m_stats.errors_reported++;
+    send_reply(ERROR_REPORT_MSG, report, sizeof(report));
+}
+
+void UecuEmulator::send_event_error(unsigned char error_code_, const EventState& event_) {
+    unsigned char report[] = {error_code_, event_.id, event_.type, event_.channel};
+    m_stats.errors_reported++;
+    send_reply(EVENT_ERROR_MSG, report, sizeof(report));
+}
+
+UecuEmulator::ScheduleState* UecuEmulator::find_schedule(unsigned char id_) {
+    for (size_t i = 0; i < m_schedules.size(); i++) {
+        if (m_schedules[i].id == id_) return &m_schedules[i];
+    }
+    return nullptr;
+}
+
+UecuEmulator::EventState* UecuEmulator::find_event(unsigned char id_) {
+    for (size_t i = 0; i < m_events.size(); i++) {
+        if (m_events[i].id == id_) return &m_events[i];
+    }
+    return nullptr;
+}
+
+bool UecuEmulator::check_limits(const EventState& event_, unsigned char pw_, unsigned char amplitude_) {
+    const ChannelState& channel = m_channels[event_.channel];
+    if (pw_ > channel.max_pw || amplitude_ > channel.max_amplitude) {
+        send_event_error(UECU_ERR_LIMIT, event_);
+        return false;
+    }
+    return true;
+}
+
+}  // namespace fes
+}  // namespace mahi
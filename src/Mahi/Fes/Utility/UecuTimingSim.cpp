@@ -0,0 +1,310 @@
+// MIT License
+//
+// Copyright (c) 2020 Mechatronics and Haptic Interfaces Lab - Rice University
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// Author(s): Nathan Dunkelberger (nbd2@rice.edu)
+
+#include <Mahi/Fes/Core/Event.hpp>
+#include <Mahi/Fes/Utility/UecuTimingSim.hpp>
+#include <Mahi/Fes/Utility/Utility.hpp>
+#include <Mahi/Util.hpp>
+#include <algorithm>
+#include <fstream>
+
+using namespace mahi::util;
+
+namespace mahi {
+namespace fes {
+
+namespace {
+/// combines the two bytes of a 16 bit value sent high byte first
+unsigned int twobytes_to_int(unsigned char high_, unsigned char low_) { return ((unsigned int)high_ << 8) | low_; }
+}  // namespace
+
+UecuTimingSim::UecuTimingSim(unsigned int baud_rate_, bool charge_wire_time_) :
+    // 8N1, so every byte is 10 bits on the wire
+    m_byte_time(microseconds(baud_rate_ > 0 ? 10 * 1000000 / baud_rate_ : 0)),
+    m_charge_wire_time(charge_wire_time_),
+    m_wire_free(Time::Zero),
+    m_now(Time::Zero),
+    m_frame_sent(Time::Zero) {}
+
+UecuTimingSim::~UecuTimingSim() {}
+
+void UecuTimingSim::feed(Time time_, const unsigned char* data_, size_t size_) {
+    if (time_ < m_now) time_ = m_now;
+
+    // everything the host sent up to now is known, so the pulses before now can be settled
+    advance(time_);
+
+    // the bytes go out one after the other, after anything still on the wire
+    Time wire_start = m_wire_free > time_ ? m_wire_free : time_;
+    for (size_t i = 0; i < size_; i++) {
+        if (m_frame.empty()) {
+            // every message starts with the board address followed by the host address
+            if (data_[i] != DEST_ADR) continue;
+            m_frame_sent = time_;
+        } else if (m_frame.size() == 1 && data_[i] != SRC_ADR) {
+            m_frame.clear();
+            if (data_[i] != DEST_ADR) continue;
+            m_frame_sent = time_;
+        }
+        m_frame.push_back(data_[i]);
+
+        if (m_frame.size() >= 4 && m_frame.size() == (size_t)m_frame[3] + 5) {
+            SimMessage message;
+            message.sent    = m_frame_sent;
+            message.arrival = m_charge_wire_time ? wire_start + microseconds(m_byte_time.as_microseconds() * (std::int64_t)(i + 1)) : time_;
+            message.bytes   = m_frame;
+            m_in_flight.push_back(message);
+            m_frame.clear();
+        }
+    }
+    if (m_charge_wire_time) m_wire_free = wire_start + microseconds(m_byte_time.as_microseconds() * (std::int64_t)size_);
+}
+
+void UecuTimingSim::finish(Time end_time_) { advance(end_time_); }
+
+void UecuTimingSim::reset() {
+    m_wire_free = Time::Zero;
+    m_now       = Time::Zero;
+    m_frame.clear();
+    m_in_flight.clear();
+    m_schedules.clear();
+    m_events.clear();
+    m_timeline.clear();
+    m_stats = UecuTimingSimStats();
+}
+
+const std::vector<SimPulse>& UecuTimingSim::get_timeline() { return m_timeline; }
+
+bool UecuTimingSim::write_timeline(const std::string& filename_) {
+    std::ofstream file(filename_);
+    if (!file) {
+        LOG(Error) << "Could not open " << filename_ << " to write the timeline";
+        return false;
+    }
+    file << "time,event,channel,pw,amp,age,stale\n";
+    for (size_t i = 0; i < m_timeline.size(); i++) {
+        const SimPulse& pulse = m_timeline[i];
+        file << pulse.time.as_seconds() << "," << (int)pulse.event_id << "," << (int)pulse.channel << ","
+             << (int)pulse.pulse_width << "," << (int)pulse.amplitude << "," << pulse.age.as_microseconds() / 1000.0 << ","
+             << (pulse.stale ? 1 : 0) << "\n";
+    }
+    return true;
+}
+
+UecuTimingSimStats UecuTimingSim::get_stats() { return m_stats; }
+
+void UecuTimingSim::advance(Time time_) {
+    while (true) {
+        // the next pulse of any running schedule
+        SimEvent* next_event = nullptr;
+        for (size_t i = 0; i < m_events.size(); i++) {
+            SimSchedule* schedule = find_schedule(m_events[i].schedule_id);
+            if (schedule == nullptr || !schedule->running) continue;
+            if (next_event == nullptr || m_events[i].next_pulse < next_event->next_pulse) next_event = &m_events[i];
+        }
+
+        // a message that arrives at the same time as a pulse is applied first
+        if (!m_in_flight.empty() && m_in_flight.front().arrival <= time_ &&
+            (next_event == nullptr || m_in_flight.front().arrival <= next_event->next_pulse)) {
+            m_now = m_in_flight.front().arrival;
+            apply(m_in_flight.front());
+            m_in_flight.pop_front();
+            continue;
+        }
+
+        if (next_event == nullptr || next_event->next_pulse >= time_) break;
+
+        SimPulse pulse;
+        pulse.time        = next_event->next_pulse;
+        pulse.event_id    = next_event->id;
+        pulse.channel     = next_event->channel;
+        pulse.pulse_width = next_event->pulse_width;
+        pulse.amplitude   = next_event->amplitude;
+        pulse.age         = pulse.time - next_event->sent;
+        pulse.stale       = false;
+        for (size_t i = 0; i < m_in_flight.size() && m_in_flight[i].sent <= pulse.time; i++) {
+            const std::vector<unsigned char>& bytes = m_in_flight[i].bytes;
+            if (bytes[2] == CHANGE_EVENT_PARAMS_MSG && bytes[4] == next_event->id) pulse.stale = true;
+        }
+        m_timeline.push_back(pulse);
+        m_stats.pulses++;
+        if (pulse.stale) m_stats.stale_pulses++;
+        if (pulse.age > m_stats.max_age) m_stats.max_age = pulse.age;
+
+        m_now = pulse.time;
+        SimSchedule* schedule = find_schedule(next_event->schedule_id);
+        if (schedule->period > Time::Zero) {
+            next_event->next_pulse = next_event->next_pulse + schedule->period;
+        } else {
+            // a schedule without a period would fire forever at the same instant
+            schedule->running = false;
+        }
+    }
+    if (time_ > m_now) m_now = time_;
+}
+
+void UecuTimingSim::apply(const SimMessage& message_) {
+    m_stats.messages++;
+    if (message_.arrival - message_.sent > m_stats.max_arrival) m_stats.max_arrival = message_.arrival - message_.sent;
+
+    unsigned char        type = message_.bytes[2];
+    const unsigned char* data = &message_.bytes[4];
+    Time                 now  = message_.arrival;
+
+    switch (type) {
+        case CREATE_SCHEDULE_MSG: {
+            SimSchedule schedule;
+            schedule.id = 1;
+            while (find_schedule(schedule.id) != nullptr) schedule.id++;
+            schedule.sync_char = data[0];
+            schedule.period    = milliseconds(twobytes_to_int(data[1], data[2]));
+            schedule.start     = now;
+            schedule.running   = false;
+            m_schedules.push_back(schedule);
+            break;
+        }
+        case DELETE_SCHEDULE_MSG: {
+            unsigned char id = data[0];
+            m_events.erase(std::remove_if(m_events.begin(), m_events.end(),
+                                          [id](const SimEvent& event) { return event.schedule_id == id; }),
+                           m_events.end());
+            m_schedules.erase(std::remove_if(m_schedules.begin(), m_schedules.end(),
+                                             [id](const SimSchedule& schedule) { return schedule.id == id; }),
+                              m_schedules.end());
+            break;
+        }
+        case CHANGE_SCHEDULE_MSG: {
+            SimSchedule* schedule = find_schedule(data[0]);
+            if (schedule == nullptr) break;
+            schedule->sync_char = data[1];
+            schedule->period    = milliseconds(twobytes_to_int(data[2], data[3]));
+            break;
+        }
+        case CHANGE_SCHEDULE_STATE_MSG: {
+            SimSchedule* schedule = find_schedule(data[0]);
+            if (schedule == nullptr) break;
+            bool running = data[1] != 0x00;
+            if (running && !schedule->running) {
+                // a resumed schedule starts a new period
+                schedule->start = now;
+                for (size_t i = 0; i < m_events.size(); i++) {
+                    if (m_events[i].schedule_id == schedule->id) m_events[i].next_pulse = now + m_events[i].delay;
+                }
+            }
+            schedule->running = running;
+            break;
+        }
+        case CREATE_EVENT_MSG: {
+            SimSchedule* schedule = find_schedule(data[0]);
+            if (schedule == nullptr) break;
+            SimEvent event;
+            event.id = 1;
+            while (find_event(event.id) != nullptr) event.id++;
+            event.schedule_id = data[0];
+            event.delay       = milliseconds(twobytes_to_int(data[1], data[2]));
+            event.channel     = data[5];
+            event.pulse_width = data[6];
+            event.amplitude   = data[7];
+            event.sent        = message_.sent;
+            event.next_pulse  = schedule->running ? first_pulse(*schedule, event, now) : now;
+            m_events.push_back(event);
+            break;
+        }
+        case DELETE_EVENT_MSG: {
+            unsigned char id = data[0];
+            m_events.erase(std::remove_if(m_events.begin(), m_events.end(),
+                                          [id](const SimEvent& event) { return event.id == id; }),
+                           m_events.end());
+            break;
+        }
+        case CHANGE_EVENT_SCHED_MSG: {
+            SimEvent*    event    = find_event(data[0]);
+            SimSchedule* schedule = find_schedule(data[1]);
+            if (event == nullptr || schedule == nullptr) break;
+            event->schedule_id = data[1];
+            event->delay       = milliseconds(twobytes_to_int(data[2], data[3]));
+            if (schedule->running) event->next_pulse = first_pulse(*schedule, *event, now);
+            break;
+        }
+        case CHANGE_EVENT_PARAMS_MSG: {
+            SimEvent* event = find_event(data[0]);
+            if (event == nullptr) break;
+            event->pulse_width = data[1];
+            event->amplitude   = data[2];
+            event->sent        = message_.sent;
+            break;
+        }
+        case SYNC_MSG: {
+            for (size_t i = 0; i < m_schedules.size(); i++) {
+                if (m_schedules[i].sync_char != data[0]) continue;
+                m_schedules[i].start   = now;
+                m_schedules[i].running = true;
+                for (size_t j = 0; j < m_events.size(); j++) {
+                    if (m_events[j].schedule_id == m_schedules[i].id) m_events[j].next_pulse = now + m_events[j].delay;
+                }
+            }
+            break;
+        }
+        case HALT_MSG: {
+            SimSchedule* schedule = find_schedule(data[0]);
+            if (schedule != nullptr) schedule->running = false;
+            break;
+        }
+        case EVENT_COMMAND_MSG: {
+            // a stimulus event command fires once, right away
+            if (message_.bytes[3] < 6 || data[0] != STIM_EVENT) break;
+            SimPulse pulse;
+            pulse.time        = now;
+            pulse.event_id    = 0;
+            pulse.channel     = data[2];
+            pulse.pulse_width = data[3];
+            pulse.amplitude   = data[4];
+            pulse.age         = now - message_.sent;
+            pulse.stale       = false;
+            m_timeline.push_back(pulse);
+            m_stats.pulses++;
+            if (pulse.age > m_stats.max_age) m_stats.max_age = pulse.age;
+            break;
+        }
+        default:
+            break;
+    }
+}
+
+Time UecuTimingSim::first_pulse(const SimSchedule& schedule_, const SimEvent& event_, Time time_) {
+    Time first = schedule_.start + event_.delay;
+    if (first >= time_ || schedule_.period <= Time::Zero) return first;
+    // skip the periods that are already over
+    std::int64_t periods = ((time_ - first).as_microseconds() + schedule_.period.as_microseconds() - 1) / schedule_.period.as_microseconds();
+    return first + microseconds(periods * schedule_.period.as_microseconds());
+}
+
+UecuTimingSim::SimSchedule* UecuTimingSim::find_schedule(unsigned char id_) {
+    for (size_t i = 0; i < m_schedules.size(); i++) {
+        if (m_schedules[i].id == id_) return &m_schedules[i];
+    }
+    return nullptr;
+}
+
+UecuTimingSim::SimEvent* UecuTimingSim::find_event(unsigned char id_) {
+    for (size_t i = 0; i < m_events.size(); i++) {
+        if (m_events[i].id == id_) return &m_events[i];
+    }
+    return nullptr;
+}
+
+}  // namespace fes
+}  // namespace mahi
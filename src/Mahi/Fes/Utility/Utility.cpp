@@ -17,8 +17,6 @@
 #include <Mahi/Util.hpp>
 #include <vector>
 
-#include "Windows.h"
-
 using namespace mahi::util;
 
 namespace mahi {
@@ -14,13 +14,9 @@
 //
 // Author(s): Nathan Dunkelberger (nbd2@rice.edu)
 
-#include <Windows.h>
-#include <tchar.h>
-
 #include <Mahi/Fes/Utility/VirtualStim.hpp>
 #include <Mahi/Gui.hpp>
 #include <Mahi/Util.hpp>
-#include <codecvt>
 #include <mutex>
 #include <thread>
 
@@ -34,7 +30,6 @@ VirtualStim::VirtualStim(const std::string& com_port_) :
     m_com_port(com_port_),
     m_recent_messages(39) {
     open_port();
-    configure_port();
 
     ImGui::StyleColorsLight();
     m_poll_thread = std::thread(&VirtualStim::poll, this);
@@ -143,26 +138,10 @@ void VirtualStim::add_monitor(SerialMessage ser_msg) {
 }
 
 bool VirtualStim::open_port() {
-    // the comport must be formatted as an LPCWSTR, so we need to get it into that form from a
-    // std::string
-    std::wstring com_prefix = L"\\\\.\\";
-    std::wstring com_suffix =
-        std::wstring_convert<std::codecvt_utf8<wchar_t>>().from_bytes(m_com_port);
-    std::wstring comID = com_prefix + com_suffix;
-
-    // std::wstring stemp = std::wstring(com_port_formatted.begin(), com_port_formatted.end());
-    // LPCWSTR com_port_lpcwstr = stemp.c_str();
+    m_transport = make_serial_transport(m_com_port);
 
-    m_hComm = CreateFileW(comID.c_str(),                 // port name
-                        GENERIC_READ | GENERIC_WRITE,  // Read/Write
-                        0,                             // No Sharing
-                        NULL,                          // No Security
-                        OPEN_EXISTING,                 // Open existing port only
-                        0,                             // Non Overlapped I/O
-                        NULL);                         // Null for Comm Devices
-
-    // Check if creating the comport was successful or not and log it
-    if (m_hComm == INVALID_HANDLE_VALUE) {
+    // Check if opening the comport was successful or not and log it
+    if (!m_transport->open()) {
         LOG(Error) << "Failed to open Virtual Stimulator";
         return false;
     } else {
@@ -172,74 +151,18 @@ bool VirtualStim::open_port() {
     return true;
 }
 
-bool VirtualStim::configure_port() {  // configure_port establishes the settings for each serial
-                                      // port
-
-    // http://bd.eduweb.hhs.nl/micprg/pdf/serial-win.pdf
-
-    m_dcbSerialParams.DCBlength = sizeof(DCB);
-
-    if (!GetCommState(m_hComm, &m_dcbSerialParams)) {
-        LOG(Error) << "Error getting serial port state";
-        return false;
-    }
-
-    // set parameters to use for serial communication
-
-    // set the baud rate that we will communicate at to 9600
-    m_dcbSerialParams.BaudRate = CBR_9600;
-
-    // 8 bits in the bytes transmitted and received.
-    m_dcbSerialParams.ByteSize = 8;
-
-    // Specify that we are using one stop bit
-    m_dcbSerialParams.StopBits = ONESTOPBIT;
-
-    // Specify that we are using no parity
-    m_dcbSerialParams.Parity = NOPARITY;
-
-    // Disable all parameters dealing with flow control
-    m_dcbSerialParams.fOutX       = FALSE;
-    m_dcbSerialParams.fInX        = FALSE;
-    m_dcbSerialParams.fRtsControl = RTS_CONTROL_DISABLE;
-    m_dcbSerialParams.fDtrControl = DTR_CONTROL_DISABLE;
-
-    // Set communication parameters for the serial port
-    if (!SetCommState(m_hComm, &m_dcbSerialParams)) {
-        LOG(Error) << "Error setting serial port state";
-        return false;
-    }
-
-    COMMTIMEOUTS timeouts                = {0};
-    timeouts.ReadIntervalTimeout         = 50;
-    timeouts.ReadTotalTimeoutConstant    = 50;
-    timeouts.ReadTotalTimeoutMultiplier  = 10;
-    timeouts.WriteTotalTimeoutConstant   = 50;
-    timeouts.WriteTotalTimeoutMultiplier = 10;
-    if (!SetCommTimeouts(m_hComm, &timeouts)) {
-        LOG(Error) << "Error setting serial port timeouts";
-        return false;
-    }
-    return true;
-}
-
 void VirtualStim::poll() {
     // bool done_reading = false;
     Clock poll_clock;
     poll_clock.restart();
     while (m_open) {
-        DWORD         header_size = 4;
+        const size_t  header_size = 4;
         unsigned char msg_header[4];
 
-        DWORD dwBytesRead = 0;
-
-        if (!ReadFile(m_hComm, msg_header, header_size, &dwBytesRead, NULL)) {
-            LOG(Error) << "Error reading from comport.";
-        }
-        if (dwBytesRead != 0) {
-            DWORD body_size = (unsigned int)msg_header[3] + 1;
+        if (m_transport->read_exact(msg_header, header_size, milliseconds(50)) == header_size) {
+            size_t body_size = (unsigned int)msg_header[3] + 1;
             std::unique_ptr<unsigned char[]> msg_body(new unsigned char[body_size]);
-            if (!ReadFile(m_hComm, msg_body.get(), body_size, &dwBytesRead, NULL)) {
+            if (m_transport->read_exact(msg_body.get(), body_size, milliseconds(50)) != body_size) {
                 LOG(Error) << "Could not read message body";
             } else {
                 if (msg_header[0] == (unsigned char)0x04 && msg_header[1] == (unsigned char)0x80) {